@@ -0,0 +1,475 @@
+#ifndef ENGINE_H
+# define ENGINE_H
+
+# include "fractol.h"
+# include "simd.h"
+
+/*
+ * Motore vettoriale comune a tutti i frattali escape-time. Ogni riga viene
+ * descritta da t_row (reale iniziale, passo, immaginario, numero di pixel,
+ * uscita): le coordinate si ottengono con una moltiplicazione, senza la
+ * divisione per scale di ogni pixel. I pixel vengono calcolati a gruppi di
+ * VD_LANES (o VF_LANES) corsie: le corsie gia' fuggite restano ferme
+ * (maschera "in") e il gruppo termina quando sono fuggite tutte.
+ *
+ * mode (KMODE_*) e power sono costanti in ogni kernel che chiama row_d o
+ * row_f: dopo l'inlining il compilatore elimina i rami degli altri modi e
+ * srotola la potenza in una sequenza fissa di quadrati e prodotti, senza
+ * pow() ne' cicli. Ogni kernel e' quindi specializzato per il suo frattale.
+ */
+
+/*
+ * Valore di fuga scritto dai kernel. Senza smooth e' la profondita'
+ * intera. Con smooth (bailout SMOOTH_BAILOUT) si aggiunge la parte
+ * frazionaria ricavata dall'ultimo |z|:
+ *   mu = depth + 1 - log2(log|z|) / log2(power)
+ * che varia in modo continuo tra una banda e l'altra. Un mu non finito
+ * (|z| infinito o NaN) conta come punto interno: vale iteration e il pixel
+ * resta nero invece di finire fuori dalla palette.
+ */
+static inline float	escape_value(const t_frame *fr, int depth, double mag2)
+{
+	double	mu;
+
+	if (!fr->smooth || depth >= fr->iteration)
+		return (depth);
+	mu = depth + 1 - log2(0.5 * log(mag2)) / fr->log2_power;
+	if (!isfinite(mu))
+		return (fr->iteration);
+	if (mu < 0)
+		mu = 0;
+	return (mu);
+}
+
+/*
+ * ORBIT TRAP - Invece della profondita' di fuga si colora con la distanza
+ * minima dell'orbita da una figura (la "trappola"). La distanza al
+ * quadrato e' il minimo di quattro termini:
+ *   Re(z)²                  retta Re z = 0
+ *   Im(z)²                  retta Im z = 0 (la "linea")
+ *   |z|²                    l'origine (il "punto")
+ *   ((|z|² - R²) / 2R)²     il cerchio di raggio TRAP_RADIUS, vicino al
+ *                           cerchio vale circa (|z| - R)², senza sqrt
+ * La croce usa le due rette. I termini spenti ricevono +inf da
+ * fr->trap_off e non vincono mai il minimo: il ciclo non ha rami sul tipo
+ * di trappola, solo somme e minimi vettoriali, e i quadrati sono quelli
+ * gia' calcolati per il test di fuga. I quattro termini si riducono ad
+ * albero e solo l'ultimo minimo dipende dall'iterazione precedente. Le
+ * corsie gia' fuggite hanno z fermo e il minimo non cambia piu'.
+ */
+static inline float	trap_value(const t_frame *fr, double best)
+{
+	double	v;
+
+	v = -0.5 * TRAP_BANDS * log2(best);
+	if (!(v > 0))
+		return (0);
+	if (v > fr->iteration - 1)
+		return (fr->iteration - 1);
+	return (v);
+}
+
+static inline t_vd	trap_d(const t_frame *fr, t_vd re2, t_vd im2, t_vd best)
+{
+	t_vd	ring;
+
+	ring = (re2 + im2 - TRAP_RADIUS * TRAP_RADIUS) / (2 * TRAP_RADIUS);
+	ring = vd_min(vd_min(re2 + fr->trap_off[0], im2 + fr->trap_off[1]),
+			vd_min(re2 + im2 + fr->trap_off[2],
+				ring * ring + fr->trap_off[3]));
+	return (vd_min(best, ring));
+}
+
+static inline t_vf	trap_f(const t_frame *fr, t_vf re2, t_vf im2, t_vf best)
+{
+	t_vf	ring;
+
+	ring = (re2 + im2 - (float)(TRAP_RADIUS * TRAP_RADIUS))
+		/ (float)(2 * TRAP_RADIUS);
+	ring = vf_min(vf_min(re2 + (float)fr->trap_off[0],
+				im2 + (float)fr->trap_off[1]),
+			vf_min(re2 + im2 + (float)fr->trap_off[2],
+				ring * ring + (float)fr->trap_off[3]));
+	return (vf_min(best, ring));
+}
+
+/* w = w², w = w * z: i due mattoni della potenza intera. */
+static inline void	csq_d(t_vd *w)
+{
+	t_vd	re;
+
+	re = w[0] * w[0] - w[1] * w[1];
+	w[1] = 2 * w[0] * w[1];
+	w[0] = re;
+}
+
+static inline void	cmul_d(t_vd *w, const t_vd *z)
+{
+	t_vd	re;
+
+	re = w[0] * z[0] - w[1] * z[1];
+	w[1] = w[0] * z[1] + w[1] * z[0];
+	w[0] = re;
+}
+
+/* w = w / z = w * conj(z) / |z|² */
+static inline void	cdiv_d(t_vd *w, const t_vd *z)
+{
+	t_vd	conj[2];
+	t_vd	mag2;
+
+	conj[0] = z[0];
+	conj[1] = -z[1];
+	mag2 = z[0] * z[0] + z[1] * z[1];
+	cmul_d(w, conj);
+	w[0] /= mag2;
+	w[1] /= mag2;
+}
+
+/* sin, cos, exp and log of one lane. */
+static inline void	clane_d(int op, double *re, double *im)
+{
+	double	x;
+	double	y;
+
+	x = *re;
+	y = *im;
+	if (op == OP_SIN)
+	{
+		*re = sin(x) * cosh(y);
+		*im = cos(x) * sinh(y);
+	}
+	else if (op == OP_COS)
+	{
+		*re = cos(x) * cosh(y);
+		*im = -sin(x) * sinh(y);
+	}
+	else if (op == OP_EXP)
+	{
+		*re = exp(x) * cos(y);
+		*im = exp(x) * sin(y);
+	}
+	else
+	{
+		*re = 0.5 * log(x * x + y * y);
+		*im = atan2(y, x);
+	}
+}
+
+/*
+ * w = f(z) senza la costante c. Per le potenze da 2 a 8 la catena di
+ * quadrati e prodotti e' la piu' corta: 6 = (z² z)², 7 = (z² z)² z,
+ * 8 = ((z²)²)². Burning Ship, Tricorn e Celtic sono varianti di grado 2.
+ */
+static inline void	zstep_d(const t_vd *z, t_vd *w, int mode, int power)
+{
+	w[0] = z[0];
+	w[1] = z[1];
+	if (mode == KMODE_SHIP)
+	{
+		w[0] = vd_select(z[0] < 0, -z[0], z[0]);
+		w[1] = vd_select(z[1] < 0, -z[1], z[1]);
+	}
+	csq_d(w);
+	if (mode == KMODE_TRICORN)
+		w[1] = -w[1];
+	if (mode == KMODE_CELTIC)
+		w[0] = vd_select(w[0] < 0, -w[0], w[0]);
+	if (power == 3 || power == 6 || power == 7)
+		cmul_d(w, z);
+	if (power >= 4)
+		csq_d(w);
+	if (power == 5 || power == 7)
+		cmul_d(w, z);
+	if (power == 8)
+		csq_d(w);
+}
+
+/*
+ * STIMA DELLA DISTANZA - Con row->dist il ciclo porta avanti anche la
+ * derivata dz = d z_n / d c (per i Julia d z_n / d z_0, che parte da 1):
+ *   dz = n z^(n-1) dz + 1    (il + 1 solo dove c e' il pixel)
+ * A fuga avvenuta la distanza del pixel dall'insieme e' circa
+ *   d = |z| log|z| / |dz|
+ * che row_d scrive in pixel (moltiplicata per scale). z^(n-1) riusa la
+ * catena di zstep_d; con Monster |c| e' una riflessione e non cambia |dz|.
+ */
+static inline void	dzstep_d(const t_vd *z, const t_vd *dz, t_vd *w, int mode,
+		int power)
+{
+	w[0] = z[0];
+	w[1] = z[1];
+	if (power > 2)
+		zstep_d(z, w, KMODE_MANDEL, power - 1);
+	cmul_d(w, dz);
+	w[0] = power * w[0] + (mode != KMODE_JULIA);
+	w[1] = power * w[1];
+}
+
+/* Distance estimate of one lane in pixels, 0 inside the set. */
+static inline float	distance_value(const t_frame *fr, int depth, double mag2,
+		double dmag2)
+{
+	if (depth >= fr->iteration)
+		return (0);
+	if (dmag2 <= 0)
+		return (INFINITY);
+	return (0.5 * sqrt(mag2 / dmag2) * log(mag2) * fr->scale);
+}
+
+/* Con z0 = 0 (tutti i modi tranne i Julia) la prima iterazione da' sempre
+ z1 = c esattamente: il ciclo parte gia' da z1, profondita' 1 e dz = 1,
+ cosi' la trappola non vede mai lo 0 iniziale. traps e' costante in ogni
+ chiamata (vedi row_d): il ciclo con la trappola e quello senza vengono
+ compilati separatamente. */
+static inline void	row_iter_d(const t_frame *fr, const t_row *row, int mode,
+		int power, int traps)
+{
+	t_vd	lane;
+	t_vd	z[2];
+	t_vd	w[2];
+	t_vd	dz[2];
+	t_vd	trap;
+	t_vd	cr;
+	t_vd	ci;
+	t_vmd	in;
+	t_vmd	depth;
+	int		i;
+	int		n;
+
+	n = -1;
+	while (++n < VD_LANES)
+		lane[n] = n;
+	i = 0;
+	while (i < row->count)
+	{
+		cr = row->re + (lane + i) * row->step;
+		ci = (t_vd){0} + row->im;
+		trap = (t_vd){0} + INFINITY;
+		dz[0] = (t_vd){0} + 1;
+		dz[1] = (t_vd){0};
+		if (mode == KMODE_ABS)
+		{
+			cr = vd_select(cr < 0, -cr, cr);
+			ci = vd_select(ci < 0, -ci, ci);
+		}
+		z[0] = cr;
+		z[1] = ci;
+		if (mode == KMODE_JULIA)
+		{
+			cr = (t_vd){0} + fr->jr;
+			ci = (t_vd){0} + fr->ji;
+		}
+		depth = (t_vmd){0} + (mode != KMODE_JULIA);
+		n = depth[0] - 1;
+		while (++n < fr->iteration)
+		{
+			w[0] = z[0] * z[0];
+			w[1] = z[1] * z[1];
+			if (traps)
+				trap = trap_d(fr, w[0], w[1], trap);
+			in = (w[0] + w[1] < fr->bailout);
+			if (!vmd_any(in))
+				break ;
+			if (row->dist && mode <= KMODE_ABS)
+			{
+				dzstep_d(z, dz, w, mode, power);
+				dz[1] = vd_select(in, w[1], dz[1]);
+				dz[0] = vd_select(in, w[0], dz[0]);
+			}
+			zstep_d(z, w, mode, power);
+			z[1] = vd_select(in, w[1] + ci, z[1]);
+			z[0] = vd_select(in, w[0] + cr, z[0]);
+			depth -= in;
+		}
+		n = -1;
+		while (++n < VD_LANES && i + n < row->count)
+			row->out[i + n] = escape_value(fr, depth[n],
+					z[0][n] * z[0][n] + z[1][n] * z[1][n]);
+		n = -1;
+		while (traps && ++n < VD_LANES && i + n < row->count)
+			row->out[i + n] = trap_value(fr, trap[n]);
+		n = -1;
+		while (row->dist && ++n < VD_LANES && i + n < row->count)
+			row->dist[i + n] = distance_value(fr, depth[n],
+					z[0][n] * z[0][n] + z[1][n] * z[1][n],
+					dz[0][n] * dz[0][n] + dz[1][n] * dz[1][n]);
+		i += VD_LANES;
+	}
+}
+
+static inline void	row_d(const t_frame *fr, const t_row *row, int mode,
+		int power)
+{
+	if (fr->trap)
+		row_iter_d(fr, row, mode, power, 1);
+	else
+		row_iter_d(fr, row, mode, power, 0);
+}
+
+/*
+ * Variante per le formule compilate dal JIT (jit.c): il passo e' la funzione
+ * generata, che calcola tutto il membro destro (c compresa), e z parte da c
+ * come nella VM. Il kernel generato passa una funzione static inline
+ * costante, quindi anche qui il passo viene incorporato nel ciclo.
+ */
+typedef void	(*t_zstep_d)(const t_vd *z, const t_vd *c, t_vd *w);
+
+static inline void	row_step_d(const t_frame *fr, const t_row *row,
+		t_zstep_d step)
+{
+	t_vd	lane;
+	t_vd	z[2];
+	t_vd	c[2];
+	t_vd	w[2];
+	t_vmd	in;
+	t_vmd	depth;
+	int		i;
+	int		n;
+
+	n = -1;
+	while (++n < VD_LANES)
+		lane[n] = n;
+	i = 0;
+	while (i < row->count)
+	{
+		c[0] = row->re + (lane + i) * row->step;
+		c[1] = (t_vd){0} + row->im;
+		z[0] = c[0];
+		z[1] = c[1];
+		depth = (t_vmd){0};
+		n = -1;
+		while (++n < fr->iteration)
+		{
+			in = (z[0] * z[0] + z[1] * z[1] < fr->bailout);
+			if (!vmd_any(in))
+				break ;
+			step(z, c, w);
+			z[1] = vd_select(in, w[1], z[1]);
+			z[0] = vd_select(in, w[0], z[0]);
+			depth -= in;
+		}
+		n = -1;
+		while (++n < VD_LANES && i + n < row->count)
+			row->out[i + n] = escape_value(fr, depth[n],
+					z[0][n] * z[0][n] + z[1][n] * z[1][n]);
+		i += VD_LANES;
+	}
+}
+
+/* Versione float: il doppio delle corsie, usata quando lo zoom lo permette.
+ Le coordinate sono calcolate in double e poi arrotondate. */
+static inline void	csq_f(t_vf *w)
+{
+	t_vf	re;
+
+	re = w[0] * w[0] - w[1] * w[1];
+	w[1] = 2 * w[0] * w[1];
+	w[0] = re;
+}
+
+static inline void	cmul_f(t_vf *w, const t_vf *z)
+{
+	t_vf	re;
+
+	re = w[0] * z[0] - w[1] * z[1];
+	w[1] = w[0] * z[1] + w[1] * z[0];
+	w[0] = re;
+}
+
+static inline void	zstep_f(const t_vf *z, t_vf *w, int mode, int power)
+{
+	w[0] = z[0];
+	w[1] = z[1];
+	if (mode == KMODE_SHIP)
+	{
+		w[0] = vf_select(z[0] < 0, -z[0], z[0]);
+		w[1] = vf_select(z[1] < 0, -z[1], z[1]);
+	}
+	csq_f(w);
+	if (mode == KMODE_TRICORN)
+		w[1] = -w[1];
+	if (mode == KMODE_CELTIC)
+		w[0] = vf_select(w[0] < 0, -w[0], w[0]);
+	if (power == 3 || power == 6 || power == 7)
+		cmul_f(w, z);
+	if (power >= 4)
+		csq_f(w);
+	if (power == 5 || power == 7)
+		cmul_f(w, z);
+	if (power == 8)
+		csq_f(w);
+}
+
+static inline void	row_iter_f(const t_frame *fr, const t_row *row, int mode,
+		int power, int traps)
+{
+	t_vf	z[2];
+	t_vf	w[2];
+	t_vf	trap;
+	t_vf	cr;
+	t_vf	ci;
+	t_vmf	in;
+	t_vmf	depth;
+	float	re[VF_LANES];
+	int		i;
+	int		n;
+
+	i = 0;
+	while (i < row->count)
+	{
+		n = -1;
+		while (++n < VF_LANES)
+			re[n] = row->re + (i + n) * row->step;
+		__builtin_memcpy(&cr, re, sizeof(cr));
+		ci = (t_vf){0} + (float)row->im;
+		trap = (t_vf){0} + INFINITY;
+		if (mode == KMODE_ABS)
+		{
+			cr = vf_select(cr < 0, -cr, cr);
+			ci = vf_select(ci < 0, -ci, ci);
+		}
+		z[0] = cr;
+		z[1] = ci;
+		if (mode == KMODE_JULIA)
+		{
+			cr = (t_vf){0} + (float)fr->jr;
+			ci = (t_vf){0} + (float)fr->ji;
+		}
+		depth = (t_vmf){0} + (mode != KMODE_JULIA);
+		n = depth[0] - 1;
+		while (++n < fr->iteration)
+		{
+			w[0] = z[0] * z[0];
+			w[1] = z[1] * z[1];
+			if (traps)
+				trap = trap_f(fr, w[0], w[1], trap);
+			in = (w[0] + w[1] < (float)fr->bailout);
+			if (!vmf_any(in))
+				break ;
+			zstep_f(z, w, mode, power);
+			z[1] = vf_select(in, w[1] + ci, z[1]);
+			z[0] = vf_select(in, w[0] + cr, z[0]);
+			depth -= in;
+		}
+		n = -1;
+		while (++n < VF_LANES && i + n < row->count)
+			row->out[i + n] = escape_value(fr, depth[n],
+					(double)z[0][n] * z[0][n] + (double)z[1][n] * z[1][n]);
+		n = -1;
+		while (traps && ++n < VF_LANES && i + n < row->count)
+			row->out[i + n] = trap_value(fr, trap[n]);
+		i += VF_LANES;
+	}
+}
+
+static inline void	row_f(const t_frame *fr, const t_row *row, int mode,
+		int power)
+{
+	if (fr->trap)
+		row_iter_f(fr, row, mode, power, 1);
+	else
+		row_iter_f(fr, row, mode, power, 0);
+}
+
+#endif
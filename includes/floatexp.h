@@ -0,0 +1,182 @@
+#ifndef FLOATEXP_H
+# define FLOATEXP_H
+
+# include "fractol.h"
+# include "simd.h"
+
+/*
+ * FLOATEXP - Un double con l'esponente a parte (t_fexp): valore m 2^e,
+ * con la mantissa m in [0.5, 1) ed e intero a 64 bit. La precisione e'
+ * quella del double, ma l'esponente non ha limiti pratici: serve per le
+ * differenze dei pixel oltre FEXP_SCALE_LIMIT, che in double andrebbero in
+ * underflow (sotto ~1e-308), e per i coefficienti della serie, che
+ * crescono e calano di centinaia di ordini di grandezza.
+ *
+ * - somma: si allinea l'addendo con l'esponente minore moltiplicandolo
+ *   per 2^(e_min - e_max), costruito direttamente nei bit del double; se
+ *   la differenza supera l'esponente del double l'addendo e' trascurabile
+ * - prodotto: mantisse moltiplicate, esponenti sommati
+ * - normalizzazione: l'esponente della mantissa si sposta in e leggendo e
+ *   riscrivendo i suoi bit, senza frexp
+ *
+ * La versione vettoriale (t_vfexp) ha una mantissa e un esponente per
+ * corsia. Il prodotto per un double non normalizza: la mantissa cresce di
+ * pochi bit e viene rimessa in [0.5, 1) dalla somma che segue, una volta
+ * per iterazione.
+ */
+
+typedef struct s_vfexp
+{
+	t_vd	m;
+	t_vmd	e;
+}			t_vfexp;
+
+# define FEXP_BITS		0x7ff0000000000000LL
+# define FEXP_HALF		0x3fe0000000000000LL
+
+/* Bits of a double, without going through memory. */
+typedef union u_fbits
+{
+	double	d;
+	int64_t	i;
+}			t_fbits;
+
+static inline t_fexp	fe_norm(double m, int64_t e)
+{
+	t_fexp	r;
+	t_fbits	b;
+
+	b.d = m;
+	if (!(b.i & FEXP_BITS))
+		return ((t_fexp){0, FEXP_ZERO});
+	r.e = e + ((b.i & FEXP_BITS) >> 52) - 1022;
+	b.i = (b.i & ~FEXP_BITS) | FEXP_HALF;
+	r.m = b.d;
+	return (r);
+}
+
+/* 2^k for -1022 <= k <= 1023. */
+static inline double	fe_pow2(int64_t k)
+{
+	t_fbits	b;
+
+	b.i = (k + 1023) << 52;
+	return (b.d);
+}
+
+static inline t_fexp	fe_from(double x)
+{
+	return (fe_norm(x, 0));
+}
+
+/* Rounded to double: 0 below the double range. */
+static inline double	fe_to_d(t_fexp a)
+{
+	if (a.e < -1022)
+		return (0);
+	if (a.e > 1023)
+		return (a.m * INFINITY);
+	return (a.m * fe_pow2(a.e));
+}
+
+static inline t_fexp	fe_mul(t_fexp a, t_fexp b)
+{
+	return (fe_norm(a.m * b.m, a.e + b.e));
+}
+
+static inline t_fexp	fe_mul_d(t_fexp a, double x)
+{
+	return (fe_norm(a.m * x, a.e));
+}
+
+static inline t_fexp	fe_add(t_fexp a, t_fexp b)
+{
+	t_fexp	t;
+
+	if (a.e < b.e)
+	{
+		t = a;
+		a = b;
+		b = t;
+	}
+	if (b.e - a.e < -1022)
+		return (a);
+	return (fe_norm(a.m + b.m * fe_pow2(b.e - a.e), a.e));
+}
+
+static inline t_fexp	fe_sub(t_fexp a, t_fexp b)
+{
+	b.m = -b.m;
+	return (fe_add(a, b));
+}
+
+/* a < b, both normalized and not negative. */
+static inline int	fe_less(t_fexp a, t_fexp b)
+{
+	if (a.e != b.e)
+		return (a.e < b.e);
+	return (a.m < b.m);
+}
+
+static inline t_vfexp	vfe_norm(t_vd m, t_vmd e)
+{
+	t_vfexp	r;
+	t_vmd	bits;
+	t_vmd	zero;
+
+	bits = (t_vmd)m;
+	zero = ((bits & FEXP_BITS) == 0);
+	r.e = vmd_select(zero, (t_vmd){0} + FEXP_ZERO,
+			e + ((bits & FEXP_BITS) >> 52) - 1022);
+	r.m = vd_select(zero, (t_vd){0}, (t_vd)((bits & ~FEXP_BITS) | FEXP_HALF));
+	return (r);
+}
+
+/* m 2^k lane by lane, 0 where k < -1022; k <= 1023 (deltas stay below 1). */
+static inline t_vd	vfe_scale(t_vd m, t_vmd k)
+{
+	t_vmd	far;
+
+	far = (k < -1022);
+	k = vmd_select(far, (t_vmd){0}, k);
+	return (vd_select(far, (t_vd){0}, m * (t_vd)((k + 1023) << 52)));
+}
+
+static inline t_vfexp	vfe_from(t_vd x)
+{
+	return (vfe_norm(x, (t_vmd){0}));
+}
+
+static inline t_vfexp	vfe_broadcast(t_fexp a)
+{
+	return ((t_vfexp){(t_vd){0} + a.m, (t_vmd){0} + a.e});
+}
+
+static inline t_vd	vfe_to_vd(t_vfexp a)
+{
+	return (vfe_scale(a.m, a.e));
+}
+
+static inline t_vfexp	vfe_mul(t_vfexp a, t_vfexp b)
+{
+	return (vfe_norm(a.m * b.m, a.e + b.e));
+}
+
+/* Not normalized: the mantissa grows by the few bits of x. */
+static inline t_vfexp	vfe_mul_vd(t_vfexp a, t_vd x)
+{
+	return ((t_vfexp){a.m * x, a.e});
+}
+
+static inline t_vfexp	vfe_add(t_vfexp a, t_vfexp b)
+{
+	t_vmd	big;
+	t_vmd	e;
+
+	big = (a.e >= b.e);
+	e = vmd_select(big, a.e, b.e);
+	return (vfe_norm(vd_select(big, a.m, b.m) + vfe_scale(vd_select(big,
+					b.m, a.m), vmd_select(big, b.e, a.e) - e), e));
+}
+
+#endif
@@ -5,22 +5,163 @@
 # include <stdlib.h>
 # include <math.h>
 # include <stdio.h>
+# include <stdint.h>
+# include <pthread.h>
 # include <unistd.h>
 # include <sys/time.h>
+# include <time.h>
 # include "../libft/libft.h"
 
-# define WIDTH 			1200
-# define HEIGHT			800
+# define DEFAULT_WIDTH	1200
+# define DEFAULT_HEIGHT	800
+# define MIN_WIDTH		320
+# define MIN_HEIGHT		200
 # define SCALE_LIMIT	50000000
 # define SCALE_PRS		1.3
 # define SCALE_ITER		3
+# define FRAME_MS		16
+# define SMOOTH_BAILOUT	65536.0
+# define PALETTE_STEPS	16
+# define AA_GRID		3
+# define AA_CHUNK		4
+# define MAX_THREADS	64
+# define RENDER_CHUNK	2
+# define FLOAT_SCALE_LIMIT	20000
+# define DOUBLE_SCALE_LIMIT	1e12
+# define DEEP_SCALE_LIMIT	1e560L
+# define FEXP_SCALE_LIMIT	1e290L
+# define FEXP_SWITCH		-900
+# define FEXP_ZERO		-1099511627776LL
+# define SA_TERMS		8
+# define SA_TOLERANCE	1e-12
+# define BLA_EPSILON	1e-8
+# define BLA_MEMORY		67108864
+# define BLA_LEVELS		32
+# define BLA_BACKOFF		64
+# define GLITCH_TOLERANCE	1e-6
+# define GLITCH_TILE		32
+# define GLITCH_REFS		32
+# define GLITCH_ROUNDS	8
+# define GLITCH_REUSE	48.0
+# define GLITCH_FIXED	2
+# define BIG_LIMBS		64
+# define BIG_SCRATCH		(4 * BIG_LIMBS + 64)
+# define BIG_KARATSUBA	16
+# define BIG_GUARD		64
+# define BIG_PARALLEL	32
+# define BIG_SPIN		256
+# define TILE_SIZE		64
+# define TILE_MEMORY		67108864
+# define TILE_GRIDS		32
+# define TILE_SNAP		1e-3
+# define STORE_SLOTS		16384
+# define STORE_GRIDS		1024
+# define STORE_PROBE		8
+# define STORE_MAGIC		0x46544c5354524531ULL
+# define STORE_VERSION	1
+# define NUCLEUS_NEWTON	64
+# define NUCLEUS_DIGITS	24
+# define NUCLEUS_FILL	4.0
+# define NUCLEUS_ITER	4
+# define NUCLEUS_SHRINK	12
+# define SERVER_TILE		256
+# define SERVER_CLIENTS	64
+# define SERVER_BATCH	64
+# define SERVER_LINE		512
+# define SERVER_ZOOM		60
+# define SERVER_ITER		1000000
+# define SERVER_QUEUE	33554432
+# define PREVIEW_DIV		4
+# define PREVIEW_RES		2
+# define PREVIEW_ITER	128
+# define PREVIEW_SPAN	3.6
+# define DE_WIDTH		2.0
+# define DE_AA_SKIP		4.0
+# define TRAP_RADIUS		1.0
+# define TRAP_BANDS		8.0
+# define BUDDHA_BATCH	1024
+# define BUDDHA_GRID		64
+# define BUDDHA_CELLS	4096
+# define BUDDHA_WARMUP	1000000UL
+# define BUDDHA_LIMIT	10000000000UL
+# define BUDDHA_ONE		4096
+# define BUDDHA_FLOOR	16.0
+# define BUDDHA_MIN_DEPTH	12
+# define BUDDHA_REFRESH	250000
+
+# define PREC_FLOAT		1
+# define PREC_DOUBLE	2
+# define PREC_PERTURB	3
+# define KMODE_MANDEL	0
+# define KMODE_JULIA	1
+# define KMODE_ABS		2
+# define KMODE_SHIP		3
+# define KMODE_TRICORN	4
+# define KMODE_CELTIC	5
+# define CAP_DE			1
+# define CAP_TRAP		2
+# define TRAP_NONE		0
+# define TRAP_POINT		1
+# define TRAP_LINE		2
+# define TRAP_CROSS		3
+# define TRAP_CIRCLE		4
+# define TRAP_TYPES		5
+# define NUCLEUS_IDLE	0
+# define NUCLEUS_SEARCH	1
+# define NUCLEUS_DONE	2
+# define NUCLEUS_GLIDE	3
+# define MAX_POWER		8
+# define FORMULA_CODE	64
+# define FORMULA_REGS	16
+# define FORMULA_OUT	2
+# define VM_VECS		4
+# define JIT_PATH		1024
+# define JIT_ARGS		64
+
+/* Set by the Makefile: compiler, flags and engine headers for the JIT */
+# ifndef JIT_CC
+#  define JIT_CC		"cc"
+# endif
+# ifndef JIT_FLAGS
+#  define JIT_FLAGS		"-O3 -Iincludes -Imlx_linux"
+# endif
+# ifndef JIT_INCLUDE
+#  define JIT_INCLUDE	"includes"
+# endif
+
+# define OP_MOV			0
+# define OP_CONST		1
+# define OP_ADD			2
+# define OP_SUB			3
+# define OP_MUL			4
+# define OP_DIV			5
+# define OP_NEG			6
+# define OP_POW			7
+# define OP_SIN			8
+# define OP_COS			9
+# define OP_EXP			10
+# define OP_LOG			11
+# define OP_CONJ		12
+# define OP_ABS			13
+# define OP_SQR			14
 
 # define ESC 			65307
 # define SPACE_KEY 		32
 # define W_KEY			119
+# define X_KEY			120
 # define A_KEY			97
+# define B_KEY			98
+# define C_KEY			99
 # define S_KEY			115
+# define T_KEY			116
 # define D_KEY			100
+# define E_KEY			101
+# define F_KEY			102
+# define G_KEY			103
+# define H_KEY			104
+# define J_KEY			106
+# define N_KEY			110
+# define P_KEY			112
 
 # define UP_ARROW		65362
 # define LEFT_ARROW		65361
@@ -29,6 +170,12 @@
 
 # define UP_SCROLL		0x04
 # define DOWN_SCROLL	0x05
+# define LEFT_CLICK		0x01
+
+# define MOTION_NOTIFY			6
+# define POINTER_MOTION_MASK	64
+# define CONFIGURE_NOTIFY		22
+# define STRUCTURE_NOTIFY_MASK	131072
 
 typedef struct s_color
 {
@@ -37,20 +184,196 @@ typedef struct s_color
 	int		b;
 }				t_color;
 
+/* Fixed-point number with sign and modulus: len 32-bit limbs, little-endian,
+ d[len - 1] the integer part (bignum.c). */
+typedef struct s_big
+{
+	int			sign;
+	int			len;
+	uint32_t	d[BIG_LIMBS];
+}				t_big;
+
 typedef struct s_type
 {
-	int		type;
-	int		depth;
-	int		iteration;
-	double	pixel_x;    // Current pixel x position (was: width)
-	double	pixel_y;    // Current pixel y position (was: height)
-	double	scale;      // Zoom scale factor
-	double	offset_x;   // X offset in complex plane (was: xr)
-	double	offset_y;   // Y offset in complex plane (was: yi)
-	double	cr;         // Real part of constant (for Julia set)
-	double	ci;         // Imaginary part of constant (for Julia set)
+	int			type;
+	int			iteration;
+	int			smooth;     // Kernels return a fractional escape value
+	double		bailout;    // Escape radius squared (4, SMOOTH_BAILOUT if smooth)
+	long double	scale;      // Zoom scale factor, past the double range
+	long double	offset_x;   // X offset in complex plane (was: xr), long
+	long double	offset_y;   // double, derived from center in deep zooms
+	t_big		center[2];  // Exact center of the view, at BIG_LIMBS
+	double		cr;         // Real part of constant (for Julia set)
+	double		ci;         // Imaginary part of constant (for Julia set)
+	int			custom_c;   // cr/ci override the default constant of the type
+	int			power;      // Exponent n of z^n + c (Multibrot, 2 otherwise)
 }				t_type;
 
+/* One bytecode instruction: dst = op(dst, src), or dst = re + i im. */
+typedef struct s_insn
+{
+	int		op;
+	int		dst;
+	int		src;
+	int		n;          // Exponent of OP_POW
+	double	re;         // Constant of OP_CONST
+	double	im;
+}			t_insn;
+
+/* Compiled user formula (formula.c), run by the VM kernel (vm.c). */
+typedef struct s_program
+{
+	t_insn	code[FORMULA_CODE];
+	int		count;
+	int		regs;       // Registers used, z and c included
+	int		degree;     // Estimated degree in z, for smooth coloring
+}			t_program;
+
+typedef struct s_parser
+{
+	const char	*src;
+	int			pos;
+	int			top;        // Register receiving the next operand
+	int			column;     // 1-based column of the first error
+	const char	*error;
+	t_program	*prog;
+	int			degree[FORMULA_REGS + 1];
+}				t_parser;
+
+struct	s_frame;
+
+/* One row of samples in the complex plane: count points starting at
+ (re, im), step apart on the real axis. */
+typedef struct s_row
+{
+	double	re;
+	double	step;
+	double	im;
+	int		count;
+	float	*out;
+	float	*dist;      // Distance estimates in pixels, NULL if not wanted
+	unsigned char	*glitch;    // Glitched samples of a perturbed row, or NULL
+}			t_row;
+
+/* Row kernel: escape values of the points described by row. */
+typedef void	(*t_kernel)(const struct s_frame *fr, const t_row *row);
+
+/* Registry entry; power is the degree of the formula, cr/ci the default
+ Julia constant of the type, caps the CAP_* features of the kernel
+ (distance estimates in row->dist, orbit traps). */
+typedef struct s_kernel_entry
+{
+	int			type;
+	int			power;
+	int			precision;
+	t_kernel	kernel;
+	double		cr;
+	double		ci;
+	int			caps;
+}				t_kernel_entry;
+
+/* Linear approximation of 2^level iterations starting at one index of the
+ reference: d -> a d + b dc while |d|² < r2 (bla.c). */
+typedef struct s_bla
+{
+	double	a[2];
+	double	b[2];
+	double	r2;
+}			t_bla;
+
+/* State of a reference orbit computed in fixed point: z of the current and
+ of the next iteration, c, and the handshake with the thread that computes
+ the imaginary part (perturb.c). */
+typedef struct s_bigorbit
+{
+	t_big	z[2][2];
+	t_big	c[2];
+	int		cur;        // Buffer of z holding the current iteration
+	int		turn;       // 1 while the partner thread owes its part (atomic)
+	int		quit;
+}			t_bigorbit;
+
+/* Double with an exponent of its own: m 2^e, 0.5 <= |m| < 1 once
+ normalized, m = 0 and e = FEXP_ZERO for zero (floatexp.h). */
+typedef struct s_fexp
+{
+	double	m;
+	int64_t	e;
+}			t_fexp;
+
+/* Reference orbit of a perturbed frame, its series approximation and its
+ table of linear approximations (perturb.c, bla.c). */
+typedef struct s_orbit
+{
+	double		*re;        // Z_n of the reference, rounded to double
+	double		*im;
+	int			cap;        // Entries allocated in re and im
+	int			length;     // Last index stored: Z escaped or hit iteration
+	int			reach;      // Iteration count it was computed for, 0 if none
+	double		bailout;    // Bailout it was computed for
+	t_bigorbit	*big;       // Fixed-point c and Z_length, to go on from
+	int			limbs;      // Fixed-point precision of the reference
+	double		px;         // Position of the reference in frame pixels
+	double		py;
+	double		half;       // Pixels from the reference to the view corners
+	double		radius;     // |dc| of the view corners, unit of the series
+	t_fexp		fradius;    // radius, also where double underflows
+	int			fexp;       // Deltas start below double: floatexp phase
+	int			skip;       // Iterations skipped by the series
+	int			fitted;     // Iteration count the series and table are for
+	double		box[4];     // u range of the view of the fit: x0 x1 y0 y1
+	t_fexp		fcoef[SA_TERMS][2]; // Series coefficients at skip
+	double		coef[SA_TERMS][2];  // The same rounded to double
+	t_bla		*bla;       // Linear approximations, level after level
+	int			bla_cap;    // Entries allocated in bla
+	int			bla_base;   // Shortest level kept, 2^bla_base iterations
+	int			bla_levels; // Levels built, bla_base included
+	int			bla_first[BLA_LEVELS];  // Index in bla of each level
+	int			bla_count[BLA_LEVELS];  // Entries of each level
+}				t_orbit;
+
+/* Tile of a perturbed frame with glitched pixels (glitch.c). */
+typedef struct s_tile
+{
+	int		x;          // Top-left pixel
+	int		y;
+	int		ref;        // Reference it is rendered with, -1 the main one
+	int		count;      // Glitched pixels left
+	double	cx;         // Centroid of the glitched pixels
+	double	cy;
+}			t_tile;
+
+/* Read-only view parameters of the frame being rendered. */
+typedef struct s_frame
+{
+	t_kernel	kernel;
+	int			precision;
+	double		scale;
+	double		step;
+	double		offset_x;
+	double		offset_y;
+	double		cr;
+	double		ci;
+	double		jr;
+	double		ji;
+	double		bailout;
+	double		log2_power; // log2 of the degree, for smooth coloring
+	const t_program	*program;   // User formula of the formula type
+	int			iteration;
+	int			smooth;
+	int			de;         // Distance estimates computed and shaded
+	int			trap;       // Orbit trap shape (TRAP_*), TRAP_NONE for depth
+	double		trap_off[4];    // 0 for the trap terms in use, +inf otherwise
+	const t_orbit	*orbit;     // Reference of a perturbed frame, else NULL
+}				t_frame;
+
+/* Native kernel of the current formula, loaded from the JIT cache. */
+typedef struct s_jit
+{
+	void		*handle;
+	t_kernel	kernel;
+}				t_jit;
+
 typedef struct s_mlx
 {
 	void	*mlx;
@@ -61,42 +384,456 @@ typedef struct s_mlx
 	int		endian;
 	void	*win;
 	int		color;
+	int		width;          // Current window/image size in pixels
+	int		height;
+	int		fullscreen;
+	int		saved_width;    // Windowed size to restore after fullscreen
+	int		saved_height;
 }				t_mlx;
 
+typedef struct s_palette
+{
+	uint32_t	*lut;       // Packed image word for every depth step
+	int			size;       // Number of depths covered by lut
+	int			steps;      // Entries per depth (PALETTE_STEPS if smooth)
+	int			endian;     // Image byte order the lut was packed for
+	int			dirty;      // Base color changed, lut must be rebuilt
+}				t_palette;
+
+typedef struct s_render
+{
+	int		row;        // Next row to render in the current frame
+	float	*values;    // Escape value of every pixel of the frame
+	float	*dist;      // Distance estimate of every pixel, in pixels
+	unsigned char	*glitch;    // 1 glitched, GLITCH_FIXED + k fixed by ref k
+	int		de;         // Distance-estimation rendering requested
+	int		trap;       // Orbit trap coloring requested (TRAP_*)
+	int		antialias;  // Edge-only supersampling pass enabled
+	int		aa_row;     // Next row of the anti-aliasing pass
+	int		aa_count;   // Pixels refined by the last anti-aliasing pass
+}				t_render;
+
+typedef struct s_histo
+{
+	unsigned int	*counts;    // One partial histogram per pool thread
+	float			*cdf;       // Cumulative distribution, bins + 1 entries
+	int				bins;       // Depths counted (the iteration count)
+	int				enabled;    // Histogram-equalized coloring mode
+	int				ready;      // cdf matches the current frame
+}				t_histo;
+
+typedef struct s_preview
+{
+	t_frame	frame;      // Julia frame of the inset, c under the mouse
+	float	*values;    // Escape values of the inset samples
+	int		cap;        // Floats allocated in values
+	int		enabled;    // Julia preview over the Mandelbrot view
+	int		dirty;      // c changed since the inset was drawn
+	double	cr;
+	double	ci;
+	int		x;          // Top-left corner of the inset in the window
+	int		y;
+	int		w;          // Inset size in samples (PREVIEW_RES pixels each)
+	int		h;
+}				t_preview;
+
+/* Buddhabrot / Nebulabrot renderer (buddha.c). */
+typedef struct s_buddha
+{
+	unsigned long	*counts;    // Weighted orbit hits, 3 channels per pixel
+	unsigned long	*max;       // Largest count of every row and channel
+	int				size;       // Pixels covered by counts
+	int				enabled;    // Buddhabrot mode on the Mandelbrot type
+	int				reset;      // View changed, accumulation starts over
+	int				limit[3];   // Escape depth limit of the red, green, blue
+	unsigned long	samples;    // Samples taken since the last reset
+	unsigned long	batch;      // Pool batches run, seeds the job generators
+	long			shown;      // Time of the last refresh of the image
+	unsigned long	cells[BUDDHA_CELLS];    // Weighted in-view hits per cell
+	double			cdf[BUDDHA_CELLS + 1];  // Cell sampling distribution
+	unsigned int	weight[BUDDHA_CELLS];   // Sample weight, BUDDHA_ONE units
+}				t_buddha;
+
+/* Minibrot locator (nucleus.c). The search thread works on its own copy
+ of the view and hands the result over through state. */
+typedef struct s_nucleus
+{
+	pthread_t	thread;
+	int			state;      // NUCLEUS_* (atomic)
+	int			quit;       // Asks the search thread to give up (atomic)
+	int			found;      // The search ended on a nucleus
+	int			missed;     // The last one did not, shown in the HUD
+	t_big		c[2];       // Center of the view, then the nucleus
+	t_fexp		box[2];     // Half width and height of the view searched
+	long double	scale;      // Scale of the view searched
+	int			limit;      // Longest period tried (the iteration count)
+	int			period;     // Period of the nucleus found
+	long double	size;       // Estimated size of its minibrot
+	long double	target;     // Scale the glide zooms to
+}				t_nucleus;
+
+/* Extra references of a perturbed frame (glitch.c): the main one is
+ f->orbit, these are placed on the glitches it leaves, tile by tile. */
+typedef struct s_refs
+{
+	t_orbit		orbit[GLITCH_REFS];
+	t_frame		frame[GLITCH_REFS];  // The frame, with orbit[k] as reference
+	int			count;      // References placed in the current frame
+	int			added;      // First reference of the current round
+	int			round;      // Correction rounds run in the current frame
+	int			pending;    // Frame not yet checked clean
+	t_tile		*tiles;     // Every tile of the frame
+	int			cap;        // Tiles allocated
+	int			*todo;      // Tiles still glitched, this round
+	int			left;       // Entries in todo
+}				t_refs;
+
+/* Grid of the tile cache at one scale (tiles.c): tile (i, j) covers the
+ pixels TILE_SIZE (i, j) .. TILE_SIZE (i + 1, j + 1) from origin. */
+typedef struct s_grid
+{
+	uint64_t	params;     // Hash of what the escape values depend on
+	long double	scale;
+	t_big		origin[2];  // c of pixel (0, 0)
+	uint64_t	key;        // Its grid in the tile store, 0 if none
+	int			id;         // Unique, 0 for a free slot
+	long		used;       // Frame that last used it
+}				t_grid;
+
+/* Tile of the cache: its values are at data + index * 2 TILE_SIZE². */
+typedef struct s_cached
+{
+	int			grid;       // id of its grid
+	int64_t		x;
+	int64_t		y;
+	int			prev;       // Least recently used list, head the newest
+	int			next;
+	int			chain;      // Next tile of the same hash bucket
+}				t_cached;
+
+/* Grid of the tile store, shared by every process (store.c). */
+typedef struct s_store_grid
+{
+	uint64_t	key;        // Hash of params, scale and origin, 0 if free
+	uint64_t	params;
+	long double	scale;
+	t_big		origin[2];
+	long		stamp;      // Store clock when last matched
+}				t_store_grid;
+
+/* Tile slot of the store: the values of slot k are at data + k 2
+ TILE_SIZE². seq is odd while a process writes it. */
+typedef struct s_store_slot
+{
+	uint32_t	seq;
+	int			de;         // Distances saved too
+	uint64_t	grid;       // key of its grid, 0 for a free slot
+	int64_t		x;
+	int64_t		y;
+	long		stamp;
+}				t_store_slot;
+
+/* Start of the store file; the tile data follow, page aligned. */
+typedef struct s_store_head
+{
+	uint64_t		magic;
+	uint64_t		size;       // sizeof(t_store_head), layout check
+	long			clock;      // Stores done, for the stamps
+	uint64_t		ids;        // Last grid key given out
+	t_store_grid	grid[STORE_GRIDS];
+	t_store_slot	slot[STORE_SLOTS];
+}					t_store_head;
+
+/* Tile store mapped from $XDG_CACHE_HOME/fractol/tiles. */
+typedef struct s_store
+{
+	int				opened;     // Open tried, map NULL if it failed
+	int				fd;
+	int				locked;     // Holds the file lock, between begin and end
+	t_store_head	*map;
+	float			*data;
+	size_t			length;     // Bytes mapped
+}					t_store;
+
+/* Tile cache of the rendered frames, bounded by TILE_MEMORY. A frame that
+ lands on the pixel grid of a cached scale copies the tiles it finds and
+ renders only the rest. */
+typedef struct s_tiles
+{
+	t_grid		grid[TILE_GRIDS];
+	t_cached	*tile;
+	float		*data;      // Escape values then distances of every tile
+	int			*bucket;    // First tile of each hash bucket, -1 if none
+	int			cap;        // Tiles that fit in TILE_MEMORY
+	int			count;
+	int			head;
+	int			tail;
+	int			ids;        // Last grid id given out
+	long		clock;      // Frames started
+	int			cur;        // Grid slot of the current frame, -1 if none
+	int64_t		ox;         // Grid pixel of frame pixel (0, 0)
+	int64_t		oy;
+	int			tx;         // Tiles across and down the current frame
+	int			ty;
+	unsigned char	*hit;   // Tiles of the frame copied from the cache
+	int			hit_cap;
+	int			stored;     // Finished frame already saved
+	t_store		store;
+}				t_tiles;
+
+struct	s_pool;
+
+typedef struct s_worker
+{
+	pthread_t		thread;
+	struct s_pool	*pool;
+	int				id;
+}				t_worker;
+
+typedef struct s_pool
+{
+	t_worker		*workers;
+	int				count;      // Worker threads (the caller is one more)
+	pthread_mutex_t	lock;
+	pthread_cond_t	start;
+	pthread_cond_t	done;
+	void			(*job)(void *arg, int index, int thread);
+	void			*arg;
+	int				jobs;       // Indices of the current batch
+	int				next;       // Next index to hand out (atomic)
+	int				busy;       // Workers still running the batch
+	unsigned long	batch;      // Batch generation, wakes the workers
+	int				quit;
+}				t_pool;
+
 typedef struct s_fractol
 {
-	t_mlx	mlx;
-	t_color	color;
-	t_type	fractal;
-	long	last_zoom_time;
+	t_mlx		mlx;
+	t_color		color;
+	t_palette	palette;
+	t_type		fractal;
+	t_frame		frame;
+	t_render	render;
+	t_histo		histo;
+	t_preview	preview;
+	t_buddha	buddha;
+	t_orbit		orbit;
+	t_refs		refs;
+	t_tiles		tiles;
+	t_nucleus	nucleus;
+	t_program	formula;
+	t_jit		jit;
+	t_pool		pool;
+	long		last_zoom_time;
 }				t_fractol;
 
+/* Tile request of the server (server.c). Zeroed before it is parsed, so
+ two requests for the same tile compare equal with ft_memcmp. */
+typedef struct s_request
+{
+	int			type;
+	int			iteration;
+	int			z;
+	int64_t		x;
+	int64_t		y;
+	int			png;        // PNG tile, else raw float escape values
+	int			custom;     // cr, ci given, Julia types
+	double		cr;
+	double		ci;
+	char		formula[SERVER_LINE];   // Formula type only
+}				t_request;
+
+/* Distinct tile of a batch and the clients waiting for it. */
+typedef struct s_job
+{
+	t_request	req;
+	long		waiter[SERVER_CLIENTS];  // id of each client
+	int			count;
+}				t_job;
+
+typedef struct s_client
+{
+	int			fd;         // -1 for a free slot
+	long		id;         // Unique, a new one for every connection
+	char		line[SERVER_LINE];
+	int			len;        // Bytes received, not yet parsed
+	char		*out;       // Answers not yet sent, from out + sent
+	size_t		out_len;
+	size_t		out_cap;
+	size_t		sent;
+}				t_client;
+
+typedef struct s_server
+{
+	int			fd;
+	t_client	client[SERVER_CLIENTS];
+	t_job		job[SERVER_BATCH];
+	int			jobs;
+	long		ids;        // Last client id given out
+}				t_server;
+
 /* Main functions */
 int		main(int argc, char **argv);
 void	menu(void);
 void	ft_fractol_init(t_fractol *fractol, char **av);
 int		fractal_choice(t_fractol *fractol, char **av);
 double	ft_atof(const char *str);
+long	ft_time_us(void);
+int		ft_cache_dir(char *dir, size_t size);
 
 /* Libft functions */
 void	ft_putstr_fd(char *s, int fd);
 int		ft_atoi(const char *str);
 void	ft_bzero(void *s, size_t n);
 
-/* Types of fractal */
-int		julia(t_fractol *fractol);
-int		mandelbrot(t_fractol *fractol);
-int		rabbit(t_fractol *fractol);
-int		monster(t_fractol *fractol);
+/* Types of fractal (row kernels, double and float precision) */
+void	julia_d(const t_frame *fr, const t_row *row);
+void	julia_f(const t_frame *fr, const t_row *row);
+void	mandelbrot_d(const t_frame *fr, const t_row *row);
+void	mandelbrot_f(const t_frame *fr, const t_row *row);
+void	monster_d(const t_frame *fr, const t_row *row);
+void	monster_f(const t_frame *fr, const t_row *row);
+void	multibrot3_d(const t_frame *fr, const t_row *row);
+void	multibrot3_f(const t_frame *fr, const t_row *row);
+void	multibrot4_d(const t_frame *fr, const t_row *row);
+void	multibrot4_f(const t_frame *fr, const t_row *row);
+void	multibrot5_d(const t_frame *fr, const t_row *row);
+void	multibrot5_f(const t_frame *fr, const t_row *row);
+void	multibrot6_d(const t_frame *fr, const t_row *row);
+void	multibrot6_f(const t_frame *fr, const t_row *row);
+void	multibrot7_d(const t_frame *fr, const t_row *row);
+void	multibrot7_f(const t_frame *fr, const t_row *row);
+void	multibrot8_d(const t_frame *fr, const t_row *row);
+void	multibrot8_f(const t_frame *fr, const t_row *row);
+void	ship_d(const t_frame *fr, const t_row *row);
+void	ship_f(const t_frame *fr, const t_row *row);
+void	tricorn_d(const t_frame *fr, const t_row *row);
+void	tricorn_f(const t_frame *fr, const t_row *row);
+void	celtic_d(const t_frame *fr, const t_row *row);
+void	celtic_f(const t_frame *fr, const t_row *row);
+void	formula_d(const t_frame *fr, const t_row *row);
+void	perturb_d(const t_frame *fr, const t_row *row);
+
+/* Kernel registry */
+const t_kernel_entry	*ft_kernel_lookup(int type, int power, int precision);
+void	ft_frame_row(const t_frame *fr, double px, double py, t_row *row);
+int		ft_precision_for(t_fractol *f);
+long double	ft_scale_limit(t_fractol *f);
+void	ft_frame_setup(t_fractol *f);
+void	next_power(t_fractol *f);
+
+/* Perturbation */
+int		ft_orbit_setup(t_fractol *f);
+int		ft_orbit_extra(t_fractol *f, t_orbit *o, int px, int py, int spare);
+void	ft_bla_build(t_orbit *o, size_t memory);
+
+/* Glitch correction */
+int		ft_glitch_pending(t_fractol *f);
+void	ft_glitch_round(t_fractol *f);
+void	ft_glitch_free(t_fractol *f);
+
+/* Tile cache */
+void	ft_tiles_begin(t_fractol *f);
+void	ft_tiles_row(t_fractol *f, int y, t_row *row);
+void	ft_tiles_store(t_fractol *f);
+void	ft_tiles_free(t_fractol *f);
+int		ft_tiles_offset(t_fractol *f, const t_big *c0, const t_big *origin);
+void	ft_tiles_copy(t_fractol *f, float *data, const int *p, int save);
+
+/* Tile store */
+void	ft_store_open(t_store *s);
+void	ft_store_grid(t_fractol *f, t_grid *g, const t_big *c0);
+int		ft_store_load(t_fractol *f, uint64_t key, const int64_t *g,
+			const int *p);
+void	ft_store_begin(t_store *s);
+void	ft_store_save(t_fractol *f, uint64_t key, const int64_t *g,
+			const float *data);
+void	ft_store_end(t_store *s);
+void	ft_store_close(t_store *s);
+
+/* Minibrot locator */
+int		ft_nucleus_frame(t_fractol *f);
+void	ft_nucleus_cancel(t_fractol *f);
+void	ft_nucleus_stop(t_fractol *f);
+void	toggle_nucleus(t_fractol *f);
+
+/* Fixed-point numbers */
+void	ft_big_zero(t_big *r, int len);
+void	ft_big_from_ld(t_big *r, long double x, int len);
+long double	ft_big_to_ld(const t_big *a);
+void	ft_big_resize(t_big *r, const t_big *a, int len);
+int		ft_big_limbs(long double scale);
+t_fexp	ft_big_to_fexp(const t_big *a);
+void	ft_big_from_fexp(t_big *r, t_fexp x, int len);
+int		ft_big_from_str(t_big *r, const char *s, int len);
+void	ft_big_add(t_big *r, const t_big *a, const t_big *b);
+void	ft_big_sub(t_big *r, const t_big *a, const t_big *b);
+void	ft_big_mul(t_big *r, const t_big *a, const t_big *b);
+
+/* Formula language */
+int		ft_formula_compile(t_program *prog, const char *src);
+int		ft_jit_load(t_fractol *f);
+void	ft_jit_unload(t_fractol *f);
+void	toggle_jit(t_fractol *f);
 
 /* Drawing function */
 void	random_colors(t_fractol *fractol);
-void	put_pixel(t_fractol *fractol, int depth);
+void	ft_palette_update(t_fractol *f);
+void	toggle_smooth(t_fractol *f);
+void	put_pixel(t_fractol *fractol, int x, int y, double value);
+void	ft_put_word(t_fractol *f, int x, int y, uint32_t px);
+uint32_t	ft_color(t_fractol *f, double value);
+uint32_t	ft_pack_rgb(t_fractol *f, int r, int g, int b);
+uint32_t	ft_de_shade(t_fractol *f, uint32_t px, float dist);
+void	toggle_distance(t_fractol *f);
+void	next_trap(t_fractol *f);
 void	ft_string(t_fractol *f);
 int		ft_draw(t_fractol *fractol);
+void	ft_paint_span(t_fractol *f, int y, int x0, int x1);
+int		ft_render_frame(long deadline, t_fractol *fractol);
+void	ft_render_image(t_fractol *f);
+
+/* Anti-aliasing */
+void	ft_antialias_slice(t_fractol *f, long deadline);
+void	toggle_antialias(t_fractol *f);
+
+/* Histogram coloring */
+void	ft_histogram_pass(t_fractol *f);
+double	ft_histo_map(t_fractol *f, double value);
+void	toggle_histogram(t_fractol *f);
+
+/* Julia preview */
+int		ft_preview_active(t_fractol *f);
+void	ft_preview_draw(t_fractol *f);
+int		preview_motion(int x, int y, t_fractol *f);
+void	preview_open(int x, int y, t_fractol *f);
+void	toggle_preview(t_fractol *f);
+
+/* Buddhabrot */
+int		ft_buddha_active(t_fractol *f);
+int		ft_buddha_frame(long deadline, t_fractol *f);
+void	toggle_buddha(t_fractol *f);
+
+/* Thread pool */
+int		ft_pool_init(t_pool *pool);
+void	ft_pool_run(t_pool *pool, void (*job)(void *, int, int), void *arg,
+			int jobs);
+int		ft_pool_size(t_pool *pool);
+void	ft_pool_destroy(t_pool *pool);
+
+/* Tile server */
+int		ft_serve(const char *path);
+unsigned char	*ft_png_encode(t_fractol *f, size_t *size);
+
+/* Window functions */
+int		ft_image_alloc(t_fractol *f, int width, int height);
+int		resize_window(int width, int height, t_fractol *fractol);
+void	toggle_fullscreen(t_fractol *f);
 
 /* Control function */
 int		key(int key, t_fractol *fractol);
+void	ft_view_move(t_fractol *f, long double dx, long double dy);
+void	ft_view_reset(t_fractol *f);
 void	zoom_in(int x, int y, t_fractol *f);
 void	zoom_out(int x, int y, t_fractol *f);
 int		mouse(int mouse, int x, int y, t_fractol *fractol);
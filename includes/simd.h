@@ -0,0 +1,76 @@
+#ifndef SIMD_H
+# define SIMD_H
+
+/*
+ * Vettori SIMD con le estensioni vettoriali di GCC/Clang: nessun intrinsic
+ * legato a un instruction set. Con AVX (-march=native su una CPU recente)
+ * i vettori sono da 32 byte (4 double / 8 float), altrimenti da 16 byte
+ * (SSE2, sempre presente su x86-64). I confronti restituiscono maschere
+ * di interi: -1 nelle corsie vere, 0 nelle altre.
+ */
+
+# ifdef __AVX__
+#  define VEC_BYTES		32
+# else
+#  define VEC_BYTES		16
+# endif
+
+typedef double		t_vd __attribute__((vector_size(VEC_BYTES)));
+typedef long long	t_vmd __attribute__((vector_size(VEC_BYTES)));
+typedef float		t_vf __attribute__((vector_size(VEC_BYTES)));
+typedef int			t_vmf __attribute__((vector_size(VEC_BYTES)));
+
+# define VD_LANES		(VEC_BYTES / 8)
+# define VF_LANES		(VEC_BYTES / 4)
+
+/* m ? a : b, corsia per corsia */
+static inline t_vd	vd_select(t_vmd m, t_vd a, t_vd b)
+{
+	return ((t_vd)(((t_vmd)a & m) | ((t_vmd)b & ~m)));
+}
+
+static inline t_vmd	vmd_select(t_vmd m, t_vmd a, t_vmd b)
+{
+	return ((a & m) | (b & ~m));
+}
+
+static inline t_vf	vf_select(t_vmf m, t_vf a, t_vf b)
+{
+	return ((t_vf)(((t_vmf)a & m) | ((t_vmf)b & ~m)));
+}
+
+static inline t_vd	vd_min(t_vd a, t_vd b)
+{
+	return (vd_select(a < b, a, b));
+}
+
+static inline t_vf	vf_min(t_vf a, t_vf b)
+{
+	return (vf_select(a < b, a, b));
+}
+
+static inline int	vmd_any(t_vmd m)
+{
+	long long	any;
+	int			k;
+
+	any = 0;
+	k = -1;
+	while (++k < VD_LANES)
+		any |= m[k];
+	return (any != 0);
+}
+
+static inline int	vmf_any(t_vmf m)
+{
+	int	any;
+	int	k;
+
+	any = 0;
+	k = -1;
+	while (++k < VF_LANES)
+		any |= m[k];
+	return (any != 0);
+}
+
+#endif
@@ -24,6 +24,7 @@ NAME_UNAME	= libmlx_$(UNAME).a
 
 SRC	= mlx_init.c mlx_new_window.c mlx_pixel_put.c mlx_loop.c \
 	mlx_mouse_hook.c mlx_key_hook.c mlx_expose_hook.c mlx_loop_hook.c \
+	mlx_frame_hook.c \
 	mlx_int_anti_resize_win.c mlx_int_do_nothing.c \
 	mlx_int_wait_first_expose.c mlx_int_get_visual.c \
 	mlx_flush_event.c mlx_string_put.c mlx_set_font.c \
@@ -32,7 +33,7 @@ SRC	= mlx_init.c mlx_new_window.c mlx_pixel_put.c mlx_loop.c \
 	mlx_xpm.c mlx_int_str_to_wordtab.c mlx_destroy_window.c \
 	mlx_int_param_event.c mlx_int_set_win_event_mask.c mlx_hook.c \
 	mlx_rgb.c mlx_destroy_image.c mlx_mouse.c mlx_screen_size.c \
-	mlx_destroy_display.c
+	mlx_destroy_display.c mlx_window_mode.c
 
 OBJ_DIR = obj
 OBJ	= $(addprefix $(OBJ_DIR)/,$(SRC:%.c=%.o))
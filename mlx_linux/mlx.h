@@ -86,6 +86,8 @@ int	mlx_key_hook (void *win_ptr, int (*funct_ptr)(), void *param);
 int	mlx_expose_hook (void *win_ptr, int (*funct_ptr)(), void *param);
 
 int	mlx_loop_hook (void *mlx_ptr, int (*funct_ptr)(), void *param);
+int	mlx_frame_hook (void *mlx_ptr, int (*funct_ptr)(), void *param,
+			int interval_ms);
 int	mlx_loop (void *mlx_ptr);
 int mlx_loop_end (void *mlx_ptr);
 
@@ -96,6 +98,11 @@ int mlx_loop_end (void *mlx_ptr);
 **   key_hook(int keycode, void *param);
 **   mouse_hook(int button, int x,int y, void *param);
 **   loop_hook(void *param);
+**   frame_hook(long deadline_us, void *param);
+**
+**  frame_hook is called at most once per interval_ms, deadline_us being a
+**  CLOCK_MONOTONIC time in microseconds to return by. Return non-zero to be
+**  called again next frame, 0 to sleep until the next X event.
 **
 */
 
@@ -136,4 +143,13 @@ int	mlx_mouse_show(void *mlx_ptr, void *win_ptr);
 
 int	mlx_get_screen_size(void *mlx_ptr, int *sizex, int *sizey);
 
+/*
+**  Resizable / fullscreen windows. New sizes come through
+**    mlx_hook(win_ptr, 22, 1L<<17, funct, param) as :
+**   configure_hook(int width, int height, void *param);
+*/
+
+int	mlx_window_resizable(void *mlx_ptr, void *win_ptr, int min_x, int min_y);
+int	mlx_window_fullscreen(void *mlx_ptr, void *win_ptr, int on);
+
 #endif /* MLX_H */
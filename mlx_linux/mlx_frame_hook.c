@@ -0,0 +1,23 @@
+/*
+** mlx_frame_hook.c for MiniLibX in 
+** 
+** Registers a frame-paced hook : mlx_loop() calls it at most once every
+** interval_ms milliseconds, with an absolute deadline (CLOCK_MONOTONIC,
+** microseconds) it should return by. X events are processed between calls.
+*/
+
+
+#include	"mlx_int.h"
+
+
+
+
+int	mlx_frame_hook(t_xvar *xvar,int (*funct)(),void *param,int interval_ms)
+{
+  if (interval_ms < 1)
+    interval_ms = 1;
+  xvar->frame_hook = funct;
+  xvar->frame_param = param;
+  xvar->frame_interval = (long)interval_ms * 1000;
+  return (0);
+}
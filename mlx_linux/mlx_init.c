@@ -36,6 +36,9 @@ void	*mlx_init()
 	xvar->win_list = 0;
 	xvar->loop_hook = 0;
 	xvar->loop_param = (void *)0;
+	xvar->frame_hook = 0;
+	xvar->frame_param = (void *)0;
+	xvar->frame_interval = 0;
 	xvar->do_flush = 1;
 	xvar->wm_delete_window = XInternAtom (xvar->display, "WM_DELETE_WINDOW", False);
 	xvar->wm_protocols = XInternAtom (xvar->display, "WM_PROTOCOLS", False);
@@ -24,6 +24,8 @@
 # include <unistd.h>
 # include <fcntl.h>
 # include <sys/mman.h>
+# include <sys/select.h>
+# include <time.h>
 # include <X11/Xlib.h>
 # include <X11/Xutil.h>
 # include <sys/ipc.h>
@@ -109,6 +111,9 @@ typedef struct	s_xvar
 	t_win_list	*win_list;
 	int			(*loop_hook)();
 	void		*loop_param;
+	int			(*frame_hook)();
+	void		*frame_param;
+	long		frame_interval;
 	int			use_xshm;
 	int			pshm_format;
 	int			do_flush;
@@ -53,6 +53,13 @@ int	mlx_int_param_Expose(t_xvar *xvar, XEvent *ev, t_win_list *win)
     win->hooks[Expose].hook(win->hooks[Expose].param);
 }
 
+int	mlx_int_param_ConfigureNotify(t_xvar *xvar, XEvent *ev, t_win_list *win)
+{
+  win->hooks[ConfigureNotify].hook(ev->xconfigure.width,
+				   ev->xconfigure.height,
+				   win->hooks[ConfigureNotify].param);
+}
+
 
 int	mlx_int_param_generic(t_xvar *xvar, XEvent *ev, t_win_list *win)
 {
@@ -83,7 +90,7 @@ int	(*(mlx_int_param_event[]))() =
   mlx_int_param_generic,
   mlx_int_param_generic,
   mlx_int_param_generic,
-  mlx_int_param_generic,
+  mlx_int_param_ConfigureNotify,   /* 22 */
   mlx_int_param_generic,
   mlx_int_param_generic,
   mlx_int_param_generic,
@@ -34,26 +34,101 @@ int			mlx_loop_end(t_xvar *xvar)
 	return (1);
 }
 
+static void	mlx_int_dispatch_event(t_xvar *xvar, XEvent *ev)
+{
+	t_win_list	*win;
+
+	win = xvar->win_list;
+	while (win && (win->window!=ev->xany.window))
+		win = win->next;
+
+	if (win && ev->type == ClientMessage && ev->xclient.message_type == xvar->wm_protocols && ev->xclient.data.l[0] == xvar->wm_delete_window && win->hooks[DestroyNotify].hook)
+		win->hooks[DestroyNotify].hook(win->hooks[DestroyNotify].param);
+	if (win && ev->type < MLX_MAX_EVENT && win->hooks[ev->type].hook)
+		mlx_int_param_event[ev->type](xvar, ev, win);
+}
+
+static long	mlx_int_time_us(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000000L + ts.tv_nsec / 1000);
+}
+
+/*
+** Sleep until an X event arrives or timeout_us elapses (forever if < 0).
+*/
+static void	mlx_int_wait_event(t_xvar *xvar, long timeout_us)
+{
+	fd_set			fds;
+	struct timeval	tv;
+	int				fd;
+
+	if (XPending(xvar->display))
+		return ;
+	fd = ConnectionNumber(xvar->display);
+	FD_ZERO(&fds);
+	FD_SET(fd, &fds);
+	tv.tv_sec = timeout_us / 1000000;
+	tv.tv_usec = timeout_us % 1000000;
+	select(fd + 1, &fds, 0, 0, timeout_us < 0 ? 0 : &tv);
+}
+
+/*
+** Frame-paced variant : pending events are always drained first, then the
+** frame hook gets a slice ending at now + interval. A hook returning 0 is
+** idle : the loop blocks on the X connection until the next event instead
+** of waking up every frame.
+*/
+static int	mlx_loop_paced(t_xvar *xvar)
+{
+	XEvent	ev;
+	long	now;
+	long	next;
+	int		busy;
+
+	busy = 1;
+	next = mlx_int_time_us();
+	while (win_count(xvar) && !xvar->end_loop)
+	{
+		while (!xvar->end_loop && XPending(xvar->display))
+		{
+			XNextEvent(xvar->display,&ev);
+			mlx_int_dispatch_event(xvar, &ev);
+			busy = 1;
+		}
+		if (xvar->end_loop)
+			break ;
+		now = mlx_int_time_us();
+		if (busy && now >= next)
+		{
+			next = now + xvar->frame_interval;
+			busy = xvar->frame_hook(next, xvar->frame_param);
+			if (xvar->loop_hook)
+				xvar->loop_hook(xvar->loop_param);
+			XFlush(xvar->display);
+			continue ;
+		}
+		mlx_int_wait_event(xvar, busy ? next - now : -1);
+	}
+	return (0);
+}
+
 int			mlx_loop(t_xvar *xvar)
 {
 	XEvent		ev;
-	t_win_list	*win;
 
 	mlx_int_set_win_event_mask(xvar);
 	xvar->do_flush = 0;
+	if (xvar->frame_hook)
+		return (mlx_loop_paced(xvar));
 	while (win_count(xvar) && !xvar->end_loop)
 	{
 		while (!xvar->end_loop && (!xvar->loop_hook || XPending(xvar->display)))
 		{
 			XNextEvent(xvar->display,&ev);
-			win = xvar->win_list;
-			while (win && (win->window!=ev.xany.window))
-				win = win->next;
-
-			if (win && ev.type == ClientMessage && ev.xclient.message_type == xvar->wm_protocols && ev.xclient.data.l[0] == xvar->wm_delete_window && win->hooks[DestroyNotify].hook)
-				win->hooks[DestroyNotify].hook(win->hooks[DestroyNotify].param);
-			if (win && ev.type < MLX_MAX_EVENT && win->hooks[ev.type].hook)
-				mlx_int_param_event[ev.type](xvar, &ev, win);
+			mlx_int_dispatch_event(xvar, &ev);
 		}
 		XSync(xvar->display, False);
 		if (xvar->loop_hook)
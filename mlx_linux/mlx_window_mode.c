@@ -0,0 +1,47 @@
+/*
+** mlx_window_mode.c for MiniLibX in 
+** 
+** Lift the fixed size set by mlx_int_anti_resize_win() and switch a window
+** in and out of fullscreen through the EWMH _NET_WM_STATE protocol.
+** Size changes are reported to the ConfigureNotify hook.
+*/
+
+
+#include	"mlx_int.h"
+
+
+
+
+int	mlx_window_resizable(t_xvar *xvar, t_win_list *win, int min_x, int min_y)
+{
+  XSizeHints	hints;
+  long		toto;
+
+  XGetWMNormalHints(xvar->display,win->window,&hints,&toto);
+  hints.min_width = min_x;
+  hints.min_height = min_y;
+  hints.flags = PPosition | PMinSize;
+  XSetWMNormalHints(xvar->display,win->window,&hints);
+  XFlush(xvar->display);
+  return (0);
+}
+
+
+int	mlx_window_fullscreen(t_xvar *xvar, t_win_list *win, int on)
+{
+  XEvent	ev;
+
+  bzero(&ev, sizeof(ev));
+  ev.xclient.type = ClientMessage;
+  ev.xclient.window = win->window;
+  ev.xclient.message_type = XInternAtom(xvar->display, "_NET_WM_STATE", False);
+  ev.xclient.format = 32;
+  ev.xclient.data.l[0] = on ? 1 : 0;	/* _NET_WM_STATE_ADD / _REMOVE */
+  ev.xclient.data.l[1] = XInternAtom(xvar->display,
+				     "_NET_WM_STATE_FULLSCREEN", False);
+  ev.xclient.data.l[3] = 1;
+  XSendEvent(xvar->display, xvar->root, False,
+	     SubstructureRedirectMask | SubstructureNotifyMask, &ev);
+  XFlush(xvar->display);
+  return (0);
+}
@@ -0,0 +1,164 @@
+#include "../includes/fractol.h"
+
+/*
+ * Anti-aliasing adattivo: dopo il frame normale (1 campione per pixel)
+ * vengono ricampionati solo i pixel di bordo, cioe' quelli il cui valore
+ * di fuga differisce di almeno 1 da uno dei 4 vicini. Ogni pixel di bordo
+ * riceve AA_GRID x AA_GRID campioni su una griglia stratificata con jitter
+ * deterministico (niente sfarfallio tra un frame e l'altro) e il colore
+ * finale e' la media dei campioni. Le righe sono divise tra i thread del
+ * pool.
+ *
+ * Con la stima della distanza (tasto E) un pixel a piu' di DE_AA_SKIP
+ * pixel dall'insieme non viene ricampionato anche se cambia banda: li'
+ * il colore varia lentamente e i campioni in piu' non si vedrebbero.
+ *
+ * In un frame perturbato i pixel corretti da glitch.c sono quasi sempre
+ * di bordo, perche' differiscono dai vicini: si ricampionano con il
+ * riferimento che li ha corretti (render.glitch = GLITCH_FIXED + k), non
+ * con il principale, altrimenti la media rimetterebbe dentro il glitch.
+ */
+
+typedef struct s_aa_job
+{
+	t_fractol	*f;
+	int			first;
+}				t_aa_job;
+
+static int	ft_is_edge(t_fractol *f, int x, int y)
+{
+	float	*v;
+	float	c;
+	int		w;
+
+	w = f->mlx.width;
+	if (f->frame.de && f->render.dist[y * w + x] > DE_AA_SKIP)
+		return (0);
+	v = f->render.values + y * w + x;
+	c = *v;
+	return ((x > 0 && fabsf(c - v[-1]) >= 1.0f)
+		|| (x < w - 1 && fabsf(c - v[1]) >= 1.0f)
+		|| (y > 0 && fabsf(c - v[-w]) >= 1.0f)
+		|| (y < f->mlx.height - 1 && fabsf(c - v[w]) >= 1.0f));
+}
+
+static uint32_t	ft_jitter(int x, int y, int s)
+{
+	uint32_t	h;
+
+	h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u
+		^ (uint32_t)s * 83492791u;
+	h ^= h >> 13;
+	h *= 0x5bd1e995u;
+	h ^= h >> 15;
+	return (h);
+}
+
+/* Frame pixel (x, y) is sampled with: the one of the extra reference that
+ fixed it in a perturbed frame, else the frame itself. */
+static const t_frame	*ft_aa_frame(t_fractol *f, int x, int y)
+{
+	int	k;
+
+	if (!f->frame.orbit)
+		return (&f->frame);
+	k = f->render.glitch[(size_t)y * f->mlx.width + x] - GLITCH_FIXED;
+	if (k >= 0 && k < f->refs.count && f->refs.frame[k].orbit)
+		return (&f->refs.frame[k]);
+	return (&f->frame);
+}
+
+/* Averages AA_GRID * AA_GRID jittered samples of pixel (x, y), byte lane by
+ byte lane, so the packed byte order does not matter. */
+static uint32_t	ft_aa_sample(t_fractol *f, int x, int y)
+{
+	const t_frame	*fr;
+	uint32_t		sum[4];
+	uint32_t		px;
+	uint32_t		h;
+	float			sample[2];
+	t_row			row;
+	int				s;
+	int				k;
+
+	fr = ft_aa_frame(f, x, y);
+	ft_bzero(sum, sizeof(sum));
+	row.count = 1;
+	row.out = &sample[0];
+	sample[1] = 0;
+	row.dist = NULL;
+	row.glitch = NULL;
+	if (f->frame.de)
+		row.dist = &sample[1];
+	s = -1;
+	while (++s < AA_GRID * AA_GRID)
+	{
+		h = ft_jitter(x, y, s);
+		ft_frame_row(fr,
+			x - 0.5 + (s % AA_GRID + (h & 0xFFFF) / 65536.0) / AA_GRID,
+			y - 0.5 + (s / AA_GRID + (h >> 16) / 65536.0) / AA_GRID, &row);
+		px = ft_de_shade(f, ft_color(f, sample[0]), sample[1]);
+		k = -1;
+		while (++k < 4)
+			sum[k] += (px >> (k * 8)) & 0xFF;
+	}
+	px = 0;
+	k = -1;
+	while (++k < 4)
+		px |= (sum[k] / (AA_GRID * AA_GRID)) << (k * 8);
+	return (px);
+}
+
+static void	ft_aa_row(void *arg, int index, int thread)
+{
+	t_aa_job	*job;
+	t_fractol	*f;
+	uint32_t	*dst;
+	int			count;
+	int			x;
+
+	(void)thread;
+	job = arg;
+	f = job->f;
+	index += job->first;
+	dst = (uint32_t *)(f->mlx.addr + index * f->mlx.line_length);
+	count = 0;
+	x = -1;
+	while (++x < f->mlx.width)
+	{
+		if (ft_is_edge(f, x, index))
+		{
+			dst[x] = ft_aa_sample(f, x, index);
+			count++;
+		}
+	}
+	__atomic_add_fetch(&f->render.aa_count, count, __ATOMIC_RELAXED);
+}
+
+/* Runs the AA pass in chunks of rows across the pool until the deadline.
+ The number of refined pixels is accumulated in render.aa_count. */
+void	ft_antialias_slice(t_fractol *f, long deadline)
+{
+	t_aa_job	job;
+	int			rows;
+
+	if (f->mlx.bits_per_pixel != 32)
+		f->render.aa_row = f->mlx.height;
+	job.f = f;
+	while (f->render.aa_row < f->mlx.height)
+	{
+		rows = AA_CHUNK * ft_pool_size(&f->pool);
+		if (rows > f->mlx.height - f->render.aa_row)
+			rows = f->mlx.height - f->render.aa_row;
+		job.first = f->render.aa_row;
+		ft_pool_run(&f->pool, ft_aa_row, &job, rows);
+		f->render.aa_row += rows;
+		if (ft_time_us() >= deadline)
+			break ;
+	}
+}
+
+void	toggle_antialias(t_fractol *f)
+{
+	f->render.antialias = !f->render.antialias;
+}
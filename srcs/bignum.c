@@ -0,0 +1,356 @@
+#include "../includes/fractol.h"
+#include "../includes/floatexp.h"
+
+/*
+ * NUMERI A VIRGOLA FISSA - Il centro delle viste profonde e l'orbita di
+ * riferimento hanno bisogno di centinaia o migliaia di bit: t_big e' un
+ * numero con segno e modulo, in len limb da 32 bit little-endian. L'ultimo
+ * limb (d[len - 1]) e' la parte intera, gli altri la parte frazionaria:
+ *   valore = segno * somma d[i] 2^(32 (i - len + 1))
+ * La parte intera basta per l'orbita: prima della fuga |z|² < bailout.
+ *
+ * - somma e differenza: sul modulo, limb per limb con riporto
+ * - prodotto: Karatsuba sopra BIG_KARATSUBA limb, scolastico sotto; del
+ *   prodotto di 2 len limb si tengono i len che stanno sulla virgola
+ *   (troncamento verso zero)
+ * - lettura da stringa decimale: le cifre frazionarie si aggiungono
+ *   dall'ultima alla prima dividendo ogni volta per 10, cosi' ogni cifra
+ *   conta per intero e non si passa mai dal double
+ *
+ * Tutte le funzioni sono rientranti (nessuno stato globale, buffer sullo
+ * stack): l'orbita le usa da due thread insieme.
+ */
+
+/* n limbs of a into r, a = NULL for zeros: libft copies byte by byte. */
+static void	ft_big_copy(uint32_t *r, const uint32_t *a, int n)
+{
+	int	i;
+
+	i = -1;
+	while (++i < n)
+		r[i] = a ? a[i] : 0;
+}
+
+void	ft_big_zero(t_big *r, int len)
+{
+	ft_big_copy(r->d, NULL, len);
+	r->sign = 1;
+	r->len = len;
+}
+
+/* x at len limbs; |x| must fit the integer limb. */
+void	ft_big_from_ld(t_big *r, long double x, int len)
+{
+	int	i;
+
+	ft_big_zero(r, len);
+	if (x < 0)
+		r->sign = -1;
+	x = fabsl(x);
+	r->d[len - 1] = (uint32_t)x;
+	x -= r->d[len - 1];
+	i = len - 1;
+	while (--i >= 0 && x > 0)
+	{
+		x *= 4294967296.0L;
+		r->d[i] = (uint32_t)x;
+		x -= r->d[i];
+	}
+}
+
+/* Rounded to long double: the top three limbs hold more than its 64 bits. */
+long double	ft_big_to_ld(const t_big *a)
+{
+	long double	x;
+	int			i;
+
+	x = 0;
+	i = a->len - 4;
+	if (i < 0)
+		i = -1;
+	while (++i < a->len)
+		x = x / 4294967296.0L + a->d[i];
+	return (a->sign * x);
+}
+
+/* The same number at len limbs: the top len limbs of a, or a with zeros
+ below when len is larger. r is not a. */
+void	ft_big_resize(t_big *r, const t_big *a, int len)
+{
+	int	pad;
+
+	pad = len - a->len;
+	if (pad < 0)
+		pad = 0;
+	ft_big_copy(r->d, NULL, pad);
+	ft_big_copy(r->d + pad, a->d + a->len - len + pad, len - pad);
+	r->sign = a->sign;
+	r->len = len;
+}
+
+/* Limbs that resolve a pixel at scale with BIG_GUARD bits to spare. */
+int	ft_big_limbs(long double scale)
+{
+	int	limbs;
+
+	limbs = (log2l(scale) + BIG_GUARD) / 32 + 2;
+	if (limbs > BIG_LIMBS)
+		limbs = BIG_LIMBS;
+	return (limbs);
+}
+
+/* Rounded to floatexp from the first limb that is not zero: unlike
+ ft_big_to_ld it keeps every digit of a number far below 1. */
+t_fexp	ft_big_to_fexp(const t_big *a)
+{
+	long double	x;
+	int			top;
+	int			i;
+
+	top = a->len;
+	while (--top >= 0 && !a->d[top])
+		;
+	if (top < 0)
+		return ((t_fexp){0, FEXP_ZERO});
+	x = 0;
+	i = top - 3;
+	if (i < -1)
+		i = -1;
+	while (++i <= top)
+		x = x / 4294967296.0L + a->d[i];
+	return (fe_norm(a->sign * (double)x,
+			32 * (int64_t)(top - a->len + 1)));
+}
+
+/* x at len limbs, |x| < 2^32: the 53 bits of the mantissa land in three
+ limbs at most, those below the last one are lost. */
+void	ft_big_from_fexp(t_big *r, t_fexp x, int len)
+{
+	double	m;
+	int64_t	q;
+	int64_t	i;
+	int		n;
+
+	ft_big_zero(r, len);
+	if (x.m == 0 || x.e < -32 * (int64_t)len)
+		return ;
+	r->sign = 1 - 2 * (x.m < 0);
+	q = x.e >> 5;
+	m = fabs(x.m) * fe_pow2(x.e - 32 * q);
+	i = q + len - 1;
+	n = -1;
+	while (++n < 3 && i >= 0)
+	{
+		if (i < len)
+			r->d[i] = (uint32_t)m;
+		m = (m - (uint32_t)m) * 4294967296.0;
+		i--;
+	}
+}
+
+/* Decimal string, "-0.743643887037158704752191506114774" and the like, at
+ full precision. Returns 1 if s is not a number. */
+int	ft_big_from_str(t_big *r, const char *s, int len)
+{
+	const char		*frac;
+	unsigned long	whole;
+	unsigned long	cur;
+	int				digits;
+	int				i;
+
+	ft_big_zero(r, len);
+	while (*s == ' ' || (*s >= '\t' && *s <= '\r'))
+		s++;
+	if (*s == '-' || *s == '+')
+		r->sign = 1 - 2 * (*s++ == '-');
+	whole = 0;
+	digits = 0;
+	while (ft_isdigit(*s) && whole <= UINT32_MAX && ++digits)
+		whole = whole * 10 + (*s++ - '0');
+	frac = s + (*s == '.');
+	s = frac;
+	while (ft_isdigit(*s) && ++digits)
+		s++;
+	if (*s || !digits || whole > UINT32_MAX)
+		return (1);
+	while (--s >= frac)
+	{
+		r->d[len - 1] = *s - '0';
+		cur = 0;
+		i = len;
+		while (--i >= 0)
+		{
+			cur = (cur << 32) | r->d[i];
+			r->d[i] = cur / 10;
+			cur %= 10;
+		}
+	}
+	r->d[len - 1] = whole;
+	return (0);
+}
+
+static int	ft_big_cmp(const uint32_t *a, const uint32_t *b, int len)
+{
+	while (--len >= 0)
+		if (a[len] != b[len])
+			return ((a[len] > b[len]) - (a[len] < b[len]));
+	return (0);
+}
+
+/* r = a + b, or a - b with a >= b, on the moduli. r may be a or b. */
+static void	ft_big_mag(uint32_t *r, const uint32_t *a, const uint32_t *b,
+		int len, int sub)
+{
+	int64_t	carry;
+	int		i;
+
+	carry = 0;
+	i = -1;
+	while (++i < len)
+	{
+		if (sub)
+			carry += (int64_t)a[i] - b[i];
+		else
+			carry += (int64_t)a[i] + b[i];
+		r[i] = (uint32_t)carry;
+		carry >>= 32;
+	}
+}
+
+/* r = a + sign b, any signs. */
+static void	ft_big_signed(t_big *r, const t_big *a, const t_big *b, int sign)
+{
+	int	bs;
+
+	bs = b->sign * sign;
+	r->len = a->len;
+	if (a->sign == bs)
+	{
+		ft_big_mag(r->d, a->d, b->d, a->len, 0);
+		r->sign = bs;
+	}
+	else if (ft_big_cmp(a->d, b->d, a->len) >= 0)
+	{
+		r->sign = a->sign;
+		ft_big_mag(r->d, a->d, b->d, a->len, 1);
+	}
+	else
+	{
+		r->sign = bs;
+		ft_big_mag(r->d, b->d, a->d, a->len, 1);
+	}
+}
+
+void	ft_big_add(t_big *r, const t_big *a, const t_big *b)
+{
+	ft_big_signed(r, a, b, 1);
+}
+
+void	ft_big_sub(t_big *r, const t_big *a, const t_big *b)
+{
+	ft_big_signed(r, a, b, -1);
+}
+
+/* r[0 .. 2n) = a b, schoolbook. */
+static void	ft_big_school(uint32_t *r, const uint32_t *a, const uint32_t *b,
+		int n)
+{
+	uint64_t	carry;
+	int			i;
+	int			j;
+
+	ft_big_copy(r, NULL, 2 * n);
+	i = -1;
+	while (++i < n)
+	{
+		carry = 0;
+		j = -1;
+		while (++j < n)
+		{
+			carry += (uint64_t)a[i] * b[j] + r[i + j];
+			r[i + j] = (uint32_t)carry;
+			carry >>= 32;
+		}
+		r[i + n] = (uint32_t)carry;
+	}
+}
+
+/* r[0 .. len) += a[0 .. n), with the carry running up to len. */
+static void	ft_big_accumulate(uint32_t *r, const uint32_t *a, int n, int len)
+{
+	uint64_t	carry;
+	int			i;
+
+	carry = 0;
+	i = -1;
+	while (++i < len && (i < n || carry))
+	{
+		carry += (uint64_t)r[i] + (i < n ? a[i] : 0);
+		r[i] = (uint32_t)carry;
+		carry >>= 32;
+	}
+}
+
+/* a[0 .. h) + a[h .. n) into s, n - h + 1 limbs. */
+static void	ft_big_halves(uint32_t *s, const uint32_t *a, int h, int n)
+{
+	ft_big_copy(s, a + h, n - h);
+	s[n - h] = 0;
+	ft_big_accumulate(s, a, h, n - h + 1);
+}
+
+/*
+ * Karatsuba: con a = a1 B^h + a0 e b = b1 B^h + b0
+ *   a b = z2 B^2h + (z1 - z2 - z0) B^h + z0
+ *   z0 = a0 b0, z2 = a1 b1, z1 = (a0 + a1)(b0 + b1)
+ * tre prodotti di meta' dimensione invece di quattro. Ogni livello usa
+ * 4 (m + 1) limb di tmp (le due somme e z1) e passa il resto ai livelli
+ * sotto: BIG_SCRATCH basta per BIG_LIMBS.
+ */
+static void	ft_big_karatsuba(uint32_t *r, const uint32_t *a, const uint32_t *b,
+		int n, uint32_t *tmp)
+{
+	uint32_t	*z1;
+	int64_t		borrow;
+	int			h;
+	int			m;
+	int			i;
+
+	if (n < BIG_KARATSUBA)
+	{
+		ft_big_school(r, a, b, n);
+		return ;
+	}
+	h = n / 2;
+	m = n - h;
+	z1 = tmp + 2 * (m + 1);
+	ft_big_halves(tmp, a, h, n);
+	ft_big_halves(tmp + m + 1, b, h, n);
+	ft_big_karatsuba(z1, tmp, tmp + m + 1, m + 1, z1 + 2 * (m + 1));
+	ft_big_karatsuba(r, a, b, h, z1 + 2 * (m + 1));
+	ft_big_karatsuba(r + 2 * h, a + h, b + h, m, z1 + 2 * (m + 1));
+	borrow = 0;
+	i = -1;
+	while (++i < 2 * (m + 1))
+	{
+		borrow += (int64_t)z1[i] - (i < 2 * h ? r[i] : 0)
+			- (i < 2 * m ? r[2 * h + i] : 0);
+		z1[i] = (uint32_t)borrow;
+		borrow >>= 32;
+	}
+	ft_big_accumulate(r + h, z1, 2 * (m + 1), 2 * n - h);
+}
+
+/* r = a b at the precision of a; r may be a or b. */
+void	ft_big_mul(t_big *r, const t_big *a, const t_big *b)
+{
+	uint32_t	p[2 * BIG_LIMBS];
+	uint32_t	tmp[BIG_SCRATCH];
+	int			n;
+
+	n = a->len;
+	ft_big_karatsuba(p, a->d, b->d, n, tmp);
+	ft_big_copy(r->d, p + n - 1, n);
+	r->sign = a->sign * b->sign;
+	r->len = n;
+}
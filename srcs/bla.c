@@ -0,0 +1,134 @@
+#include "../includes/fractol.h"
+
+/*
+ * APPROSSIMAZIONE LINEARE A BLOCCHI (BLA) - Finche' d e' piccolo rispetto a
+ * Z_m il termine d² della perturbazione e' trascurabile e un'iterazione e'
+ * lineare in d e dc:
+ *   d -> a d + b dc    con a = 2 Z_m, b = 1, valida per |d| < r = eps |a|
+ * Due passi lineari di seguito (x poi y) sono ancora un passo lineare:
+ *   a = a_y a_x    b = a_y b_x + b_y
+ *   r = min(r_x, (r_y - |b_x| max|dc|) / |a_x|)
+ * cosi' si costruisce una gerarchia: il livello l contiene i salti di 2^l
+ * iterazioni che partono da m = 1 + k 2^l, ottenuti unendo a due a due
+ * quelli del livello sotto. Un pixel all'indice m prende il salto piu'
+ * lungo che parte da m e il cui raggio contiene il suo d, e in una sola
+ * moltiplicazione complessa avanza di migliaia di iterazioni.
+ *
+ * - la tabella si costruisce una volta per orbita di riferimento
+ *   (ft_orbit_setup, sul thread principale) e i thread la leggono soltanto
+ * - Z_0 = 0 non ha un passo lineare: i livelli partono da m = 1
+ * - il raggio si restringe salendo di livello: il kernel (perturb.c)
+ *   prova prima il salto piu' corto e sale finche' d sta nel raggio
+ * - la memoria e' limitata a BLA_MEMORY per tutte le orbite del frame:
+ *   meta' alla principale, l'altra meta' divisa tra le GLITCH_REFS
+ *   orbite in piu' di glitch.c. Se l'orbita e' troppo lunga per la sua
+ *   parte si scartano i livelli piu' bassi (bla_base), i cui salti di 1,
+ *   2, 4 iterazioni fanno risparmiare poco, e li sostituisce il passo
+ *   normale
+ */
+
+static double	ft_cabs(const double *z)
+{
+	return (sqrt(z[0] * z[0] + z[1] * z[1]));
+}
+
+/* x followed by y, into x. */
+static void	ft_bla_merge(t_bla *x, const t_bla *y, double dc)
+{
+	double	re;
+	double	r;
+
+	r = (sqrt(y->r2) - ft_cabs(x->b) * dc) / ft_cabs(x->a);
+	if (!(r > 0))
+		r = 0;
+	if (r * r < x->r2)
+		x->r2 = r * r;
+	re = y->a[0] * x->b[0] - y->a[1] * x->b[1] + y->b[0];
+	x->b[1] = y->a[0] * x->b[1] + y->a[1] * x->b[0] + y->b[1];
+	x->b[0] = re;
+	re = y->a[0] * x->a[0] - y->a[1] * x->a[1];
+	x->a[1] = y->a[0] * x->a[1] + y->a[1] * x->a[0];
+	x->a[0] = re;
+}
+
+/* Single iteration at index m of the reference. */
+static void	ft_bla_step(const t_orbit *o, int m, t_bla *out)
+{
+	out->a[0] = 2 * o->re[m];
+	out->a[1] = 2 * o->im[m];
+	out->b[0] = 1;
+	out->b[1] = 0;
+	out->r2 = BLA_EPSILON * BLA_EPSILON
+		* (out->a[0] * out->a[0] + out->a[1] * out->a[1]);
+}
+
+/* Lowest level kept within memory bytes, and the entries of every level. */
+static int	ft_bla_layout(t_orbit *o, size_t memory)
+{
+	int	total;
+	int	l;
+
+	o->bla_base = 0;
+	while ((2.0 * ((o->length - 1) >> o->bla_base)) * sizeof(t_bla)
+		> memory)
+		o->bla_base++;
+	total = 0;
+	l = o->bla_base;
+	while (l < BLA_LEVELS && (o->length - 1) >> l > 0)
+	{
+		o->bla_first[l] = total;
+		o->bla_count[l] = (o->length - 1) >> l;
+		total += o->bla_count[l];
+		l++;
+	}
+	o->bla_levels = l;
+	return (total);
+}
+
+/* Table of the current reference orbit in at most memory bytes. Without
+ memory the frame simply runs without it (o->bla_levels = 0). */
+void	ft_bla_build(t_orbit *o, size_t memory)
+{
+	t_bla	step;
+	t_bla	*e;
+	int		total;
+	int		k;
+	int		i;
+
+	total = ft_bla_layout(o, memory);
+	if (total > o->bla_cap)
+	{
+		free(o->bla);
+		o->bla = malloc(sizeof(t_bla) * total);
+		o->bla_cap = total * (o->bla != NULL);
+	}
+	if (!o->bla || total == 0)
+	{
+		o->bla_levels = 0;
+		return ;
+	}
+	k = -1;
+	while (++k < o->bla_count[o->bla_base])
+	{
+		e = &o->bla[o->bla_first[o->bla_base] + k];
+		ft_bla_step(o, 1 + (k << o->bla_base), e);
+		i = 0;
+		while (++i < 1 << o->bla_base)
+		{
+			ft_bla_step(o, 1 + (k << o->bla_base) + i, &step);
+			ft_bla_merge(e, &step, o->radius);
+		}
+	}
+	i = o->bla_base;
+	while (++i < o->bla_levels)
+	{
+		k = -1;
+		while (++k < o->bla_count[i])
+		{
+			e = &o->bla[o->bla_first[i] + k];
+			*e = o->bla[o->bla_first[i - 1] + 2 * k];
+			ft_bla_merge(e, &o->bla[o->bla_first[i - 1] + 2 * k + 1],
+				o->radius);
+		}
+	}
+}
@@ -0,0 +1,379 @@
+#include "../includes/engine.h"
+
+/*
+ * BUDDHABROT / NEBULABROT - Invece di colorare ogni pixel con il tempo di
+ * fuga, si estraggono a caso dei punti c nel quadrato [-2, 2]², si itera
+ * z = z² + c e, per i c che fuggono, si disegna tutta l'orbita: ogni punto
+ * z_n che cade nella vista incrementa il contatore del suo pixel.
+ * L'immagine e' la densita' delle orbite.
+ *
+ * NEBULABROT: tre istogrammi con limiti di profondita' diversi (tutte le
+ * iterazioni, 1/4 e 1/16) diventano i canali rosso, verde e blu. I limiti
+ * sono annidati, quindi ogni pixel tiene tre contatori per classi di
+ * profondita' disgiunte (sotto 1/16, sotto 1/4, il resto) e ogni punto
+ * d'orbita ne incrementa uno solo: i canali sono le somme parziali,
+ * calcolate solo quando l'immagine viene mostrata.
+ *
+ * COME E' CALCOLATO:
+ * - la fuga si verifica a gruppi di VD_LANES c con lo stesso ciclo
+ *   vettoriale di row_d; solo le orbite dei c fuggiti vengono ripercorse
+ *   punto per punto per disegnarle (con la loro immagine speculare rispetto
+ *   all'asse reale, perche' l'insieme e' simmetrico)
+ * - i c nel cardioide e nel bulbo principale non fuggono mai e vengono
+ *   scartati prima di iterare
+ * - i thread del pool sommano sullo stesso istogramma con addizioni
+ *   atomiche (contatori a 64 bit: regge miliardi di campioni)
+ * - campionamento per importanza: il quadrato e' diviso in BUDDHA_GRID x
+ *   BUDDHA_GRID celle e ogni cella viene scelta in proporzione ai punti
+ *   che i suoi campioni hanno gia' portato nella vista (tra 1/BUDDHA_FLOOR
+ *   e BUDDHA_FLOOR volte la media). Ogni campione pesa l'inverso della sua
+ *   probabilita', in unita' di 1/BUDDHA_ONE, cosi' la densita' resta
+ *   quella del campionamento uniforme
+ * - l'immagine si raffina a ogni frame finche' la vista non cambia, fino a
+ *   BUDDHA_LIMIT campioni
+ */
+
+int	ft_buddha_active(t_fractol *f)
+{
+	return (f->buddha.enabled && f->fractal.type == 2);
+}
+
+/* splitmix64, one generator per pool job. */
+static unsigned long	ft_rand(unsigned long *s)
+{
+	unsigned long	z;
+
+	*s += 0x9E3779B97F4A7C15UL;
+	z = *s;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9UL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBUL;
+	return (z ^ (z >> 31));
+}
+
+static double	ft_unit(unsigned long *s)
+{
+	return ((ft_rand(s) >> 11) * 0x1.0p-53);
+}
+
+/* Cell k such that cdf[k] <= u < cdf[k + 1]. */
+static int	ft_buddha_cell(const t_buddha *b, double u)
+{
+	int	lo;
+	int	hi;
+	int	mid;
+
+	lo = 0;
+	hi = BUDDHA_CELLS - 1;
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (b->cdf[mid + 1] <= u)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo);
+}
+
+/* Main cardioid and period-2 bulb: orbits that never escape. */
+static int	ft_buddha_inside(double x, double y)
+{
+	double	q;
+
+	q = (x - 0.25) * (x - 0.25) + y * y;
+	return (q * (q + (x - 0.25)) < 0.25 * y * y
+		|| (x + 1) * (x + 1) + y * y < 0.0625);
+}
+
+/* Adds one orbit point to the depth class counter of its pixel. */
+static int	ft_buddha_plot(t_fractol *f, double px, double py, int class,
+		unsigned int weight)
+{
+	if (!(px >= 0 && px < f->mlx.width && py >= 0 && py < f->mlx.height))
+		return (0);
+	__atomic_add_fetch(f->buddha.counts + ((size_t)(int)py * f->mlx.width
+			+ (int)px) * 3 + class, weight, __ATOMIC_RELAXED);
+	return (1);
+}
+
+/* Replays the orbit of c, escaped after depth steps, into the counters of
+ its depth class. Returns the weighted points that hit the view. */
+static unsigned long	ft_buddha_orbit(t_fractol *f, double cr, double ci,
+		int depth, unsigned int weight)
+{
+	unsigned long	hits;
+	double			zr;
+	double			zi;
+	double			t;
+	int				class;
+
+	class = 0;
+	while (class < 2 && depth < f->buddha.limit[class + 1])
+		class++;
+	hits = 0;
+	zr = 0;
+	zi = 0;
+	while (depth-- > 0)
+	{
+		t = zr * zr - zi * zi + cr;
+		zi = 2 * zr * zi + ci;
+		zr = t;
+		t = (zr - f->frame.offset_x) * f->frame.scale;
+		hits += ft_buddha_plot(f, t, (zi - f->frame.offset_y)
+				* f->frame.scale, class, weight);
+		hits += ft_buddha_plot(f, t, (-zi - f->frame.offset_y)
+				* f->frame.scale, class, weight);
+	}
+	return (hits * weight);
+}
+
+/* VD_LANES samples: escape test in the vector loop, then the orbits of the
+ lanes that escaped. Rejected lanes start outside the bailout (depth 0);
+ orbits shorter than BUDDHA_MIN_DEPTH only add a uniform haze around the
+ sampled square and are dropped too. */
+static void	ft_buddha_group(t_fractol *f, unsigned long *rng)
+{
+	t_vd	c[2];
+	t_vd	z[2];
+	t_vd	w[2];
+	t_vmd	in;
+	t_vmd	depth;
+	int		cell[VD_LANES];
+	int		n;
+
+	z[1] = (t_vd){0};
+	n = -1;
+	while (++n < VD_LANES)
+	{
+		cell[n] = ft_buddha_cell(&f->buddha, ft_unit(rng));
+		c[0][n] = -2 + (cell[n] % BUDDHA_GRID + ft_unit(rng))
+			* 4.0 / BUDDHA_GRID;
+		c[1][n] = -2 + (cell[n] / BUDDHA_GRID + ft_unit(rng))
+			* 4.0 / BUDDHA_GRID;
+		z[0][n] = 4 * ft_buddha_inside(c[0][n], c[1][n]);
+	}
+	depth = (t_vmd){0};
+	n = -1;
+	while (++n < f->buddha.limit[0])
+	{
+		in = (z[0] * z[0] + z[1] * z[1] < 4);
+		if (!vmd_any(in))
+			break ;
+		zstep_d(z, w, KMODE_MANDEL, 2);
+		z[1] = vd_select(in, w[1] + c[1], z[1]);
+		z[0] = vd_select(in, w[0] + c[0], z[0]);
+		depth -= in;
+	}
+	n = -1;
+	while (++n < VD_LANES)
+		if (depth[n] >= BUDDHA_MIN_DEPTH && depth[n] < f->buddha.limit[0])
+			__atomic_add_fetch(&f->buddha.cells[cell[n]],
+				ft_buddha_orbit(f, c[0][n], c[1][n], depth[n],
+					f->buddha.weight[cell[n]]), __ATOMIC_RELAXED);
+}
+
+/* Pool job: BUDDHA_BATCH samples with a generator seeded by batch and job. */
+static void	ft_buddha_job(void *arg, int index, int thread)
+{
+	t_fractol		*f;
+	unsigned long	rng;
+	int				n;
+
+	(void)thread;
+	f = arg;
+	rng = f->buddha.batch * 0x100000001B3UL + index;
+	ft_rand(&rng);
+	n = 0;
+	while (n < BUDDHA_BATCH)
+	{
+		ft_buddha_group(f, &rng);
+		n += VD_LANES;
+	}
+}
+
+/* Importance distribution of the cells from the hits so far; uniform during
+ the first BUDDHA_WARMUP samples. */
+static void	ft_buddha_weights(t_buddha *b)
+{
+	double	mean;
+	double	p;
+	int		k;
+
+	mean = 0;
+	k = -1;
+	while (++k < BUDDHA_CELLS)
+		mean += (double)b->cells[k] / BUDDHA_CELLS;
+	b->cdf[0] = 0;
+	k = -1;
+	while (++k < BUDDHA_CELLS)
+	{
+		p = 1;
+		if (b->samples >= BUDDHA_WARMUP && mean > 0)
+			p = fmin(fmax(b->cells[k] / mean, 1 / BUDDHA_FLOOR), BUDDHA_FLOOR);
+		b->cdf[k + 1] = b->cdf[k] + p;
+	}
+	k = -1;
+	while (++k < BUDDHA_CELLS)
+		b->weight[k] = (unsigned int)(BUDDHA_ONE * b->cdf[BUDDHA_CELLS]
+				/ ((b->cdf[k + 1] - b->cdf[k]) * BUDDHA_CELLS) + 0.5);
+	k = -1;
+	while (++k < BUDDHA_CELLS)
+		b->cdf[k + 1] /= b->cdf[BUDDHA_CELLS];
+}
+
+/* Clears the histograms for the current view and window size. */
+static int	ft_buddha_reset(t_fractol *f)
+{
+	t_buddha	*b;
+	int			size;
+
+	b = &f->buddha;
+	b->reset = 0;
+	ft_frame_setup(f);
+	size = f->mlx.width * f->mlx.height;
+	free(b->max);
+	b->max = malloc(sizeof(unsigned long) * (f->mlx.height + 1) * 3);
+	if (size != b->size || !b->counts)
+	{
+		free(b->counts);
+		b->counts = malloc(sizeof(unsigned long) * size * 3);
+		b->size = size;
+	}
+	if (!b->counts || !b->max)
+	{
+		ft_putstr_fd("Error: Failed to allocate the Buddhabrot buffers\n", 2);
+		b->enabled = 0;
+		return (1);
+	}
+	ft_bzero(b->counts, sizeof(unsigned long) * size * 3);
+	ft_bzero(b->cells, sizeof(b->cells));
+	b->samples = 0;
+	b->shown = 0;
+	b->limit[0] = f->fractal.iteration;
+	b->limit[1] = f->fractal.iteration / 4;
+	b->limit[2] = f->fractal.iteration / 16;
+	return (0);
+}
+
+/* Red, green and blue counts of a pixel: channel k sums the depth classes
+ from k up. */
+static void	ft_buddha_channels(const unsigned long *counts, unsigned long *ch)
+{
+	ch[2] = counts[2];
+	ch[1] = counts[1] + ch[2];
+	ch[0] = counts[0] + ch[1];
+}
+
+/* Pool job: largest count of row y in every channel. */
+static void	ft_buddha_max(void *arg, int y, int thread)
+{
+	t_fractol		*f;
+	unsigned long	*counts;
+	unsigned long	*max;
+	unsigned long	ch[3];
+	int				x;
+	int				k;
+
+	(void)thread;
+	f = arg;
+	counts = f->buddha.counts + (size_t)y * f->mlx.width * 3;
+	max = f->buddha.max + y * 3;
+	ft_bzero(max, sizeof(unsigned long) * 3);
+	x = -1;
+	while (++x < f->mlx.width)
+	{
+		ft_buddha_channels(counts + x * 3, ch);
+		k = -1;
+		while (++k < 3)
+			if (ch[k] > max[k])
+				max[k] = ch[k];
+	}
+}
+
+/* Pool job: square-root tone mapping of row y against the image maxima. */
+static void	ft_buddha_paint(void *arg, int y, int thread)
+{
+	t_fractol		*f;
+	unsigned long	*counts;
+	unsigned long	*top;
+	unsigned long	ch[3];
+	float			scale[3];
+	int				x;
+
+	(void)thread;
+	f = arg;
+	counts = f->buddha.counts + (size_t)y * f->mlx.width * 3;
+	top = f->buddha.max + f->mlx.height * 3;
+	x = -1;
+	while (++x < 3)
+		scale[x] = 255.0f * 255.0f / (top[x] ? top[x] : 1);
+	x = -1;
+	while (++x < f->mlx.width)
+	{
+		ft_buddha_channels(counts + x * 3, ch);
+		ft_put_word(f, x, y, ft_pack_rgb(f, (int)sqrtf(ch[0] * scale[0]),
+				(int)sqrtf(ch[1] * scale[1]), (int)sqrtf(ch[2] * scale[2])));
+	}
+}
+
+static void	ft_buddha_show(t_fractol *f)
+{
+	unsigned long	*top;
+	int				y;
+	int				k;
+
+	ft_pool_run(&f->pool, ft_buddha_max, f, f->mlx.height);
+	top = f->buddha.max + f->mlx.height * 3;
+	ft_bzero(top, sizeof(unsigned long) * 3);
+	y = -1;
+	while (++y < f->mlx.height)
+	{
+		k = -1;
+		while (++k < 3)
+			if (f->buddha.max[y * 3 + k] > top[k])
+				top[k] = f->buddha.max[y * 3 + k];
+	}
+	ft_pool_run(&f->pool, ft_buddha_paint, f, f->mlx.height);
+	mlx_put_image_to_window(f->mlx.mlx, f->mlx.win, f->mlx.img, 0, 0);
+	ft_string(f);
+	f->buddha.shown = ft_time_us();
+}
+
+/* Frame hook of the Buddhabrot mode: sampling batches on the pool until the
+ deadline. Tone mapping the whole window costs more than a frame, so the
+ refined image is shown every BUDDHA_REFRESH us, right after a reset and
+ at the end. Returns 1 until BUDDHA_LIMIT samples. */
+int	ft_buddha_frame(long deadline, t_fractol *f)
+{
+	t_buddha	*b;
+	int			jobs;
+
+	b = &f->buddha;
+	if (b->reset && ft_buddha_reset(f) != 0)
+	{
+		ft_draw(f);
+		return (1);
+	}
+	if (b->samples >= BUDDHA_LIMIT)
+		return (0);
+	jobs = ft_pool_size(&f->pool) * 2;
+	while (b->samples < BUDDHA_LIMIT)
+	{
+		ft_buddha_weights(b);
+		ft_pool_run(&f->pool, ft_buddha_job, f, jobs);
+		b->samples += (unsigned long)jobs * BUDDHA_BATCH;
+		b->batch++;
+		if (ft_time_us() >= deadline)
+			break ;
+	}
+	if (!b->shown || ft_time_us() - b->shown >= BUDDHA_REFRESH
+		|| b->samples >= BUDDHA_LIMIT)
+		ft_buddha_show(f);
+	return (b->samples < BUDDHA_LIMIT);
+}
+
+void	toggle_buddha(t_fractol *f)
+{
+	f->buddha.enabled = !f->buddha.enabled;
+	f->buddha.reset = 1;
+}
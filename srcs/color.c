@@ -0,0 +1,149 @@
+#include "../includes/fractol.h"
+
+/* Increase the colors in the struct each time it's called. */
+void	random_colors(t_fractol *fractol)
+{
+	fractol->color.r += 15;
+	fractol->color.g += 41;
+	fractol->color.b += 10;
+	fractol->palette.dirty = 1;
+}
+
+/* Switch between banded and smooth coloring. Smooth mode needs a bigger
+ escape radius for the fractional part to be continuous. */
+void	toggle_smooth(t_fractol *f)
+{
+	f->fractal.smooth = !f->fractal.smooth;
+	f->fractal.bailout = 4;
+	if (f->fractal.smooth)
+		f->fractal.bailout = SMOOTH_BAILOUT;
+	f->palette.dirty = 1;
+}
+
+/* Pack r, g, b as one image word in the byte order returned by
+ mlx_get_data_addr (endian: 0 = least significant byte first). */
+uint32_t	ft_pack_rgb(t_fractol *f, int r, int g, int b)
+{
+	uint32_t		px;
+	uint32_t		one;
+
+	px = (uint32_t)r | ((uint32_t)g << 8) | ((uint32_t)b << 16);
+	one = 1;
+	if (f->mlx.endian != !*(unsigned char *)&one)
+		px = __builtin_bswap32(px);
+	return (px);
+}
+
+/*
+ * Rebuilds the color look-up table: one packed pixel per depth, so the
+ * render loop only does lut[depth]. In smooth mode the palette is sampled
+ * PALETTE_STEPS times per depth, so a fractional escape value is mapped
+ * through lut[(int)(value * steps)] without visible bands. It is computed
+ * again only when random_colors or the coloring mode changes it, the image
+ * byte order changes or the iteration count outgrows the table.
+ */
+void	ft_palette_update(t_fractol *f)
+{
+	t_palette	*p;
+	int			i;
+	int			steps;
+	double		depth;
+
+	p = &f->palette;
+	steps = 1;
+	if (f->fractal.smooth)
+		steps = PALETTE_STEPS;
+	if (!p->dirty && p->size > f->fractal.iteration
+		&& p->endian == f->mlx.endian && p->steps == steps)
+		return ;
+	if (p->size <= f->fractal.iteration || p->steps != steps)
+	{
+		free(p->lut);
+		p->size = (f->fractal.iteration + 1) * 2;
+		p->lut = malloc(sizeof(uint32_t) * p->size * steps);
+		if (!p->lut)
+		{
+			ft_putstr_fd("Error: Failed to allocate the palette\n", 2);
+			clean_exit(f, 1);
+		}
+	}
+	i = -1;
+	while (++i < p->size * steps)
+	{
+		depth = (double)i / steps;
+		p->lut[i] = ft_pack_rgb(f,
+				((int)(f->color.r + (depth * 2.42))) & 0xFF,
+				((int)(f->color.g + (depth * 3.52))) & 0xFF,
+				((int)(f->color.b + (depth * 4.65))) & 0xFF);
+	}
+	p->steps = steps;
+	p->endian = f->mlx.endian;
+	p->dirty = 0;
+}
+
+/* Packed color of an escape value, black inside the set and for NaN. Once
+ the histogram of the frame is known the value is equalized first. */
+uint32_t	ft_color(t_fractol *f, double value)
+{
+	if (!(value < f->fractal.iteration))
+		return (0);
+	if (f->histo.enabled && f->histo.ready)
+		value = ft_histo_map(f, value);
+	return (f->palette.lut[(int)(value * f->palette.steps)]);
+}
+
+/*
+ * Colorazione con la stima della distanza (tasto E): un pixel a meno di
+ * DE_WIDTH pixel dall'insieme viene scurito in proporzione alla distanza.
+ * Il bordo diventa una linea netta larga circa un pixel, e i filamenti
+ * piu' sottili di un pixel, che il solo conteggio delle iterazioni perde
+ * tra un campione e l'altro, restano visibili e continui.
+ */
+uint32_t	ft_de_shade(t_fractol *f, uint32_t px, float dist)
+{
+	uint32_t	k;
+
+	if (!f->frame.de || !(dist < DE_WIDTH))
+		return (px);
+	k = (uint32_t)(dist / DE_WIDTH * 256);
+	return ((((px & 0xFF00FF) * k >> 8) & 0xFF00FF)
+		| (((px >> 8) & 0xFF00FF) * k & 0xFF00FF00));
+}
+
+void	toggle_distance(t_fractol *f)
+{
+	f->render.de = !f->render.de;
+}
+
+/* Orbit trap coloring: point, line, cross, circle, then back to depth. */
+void	next_trap(t_fractol *f)
+{
+	f->render.trap = (f->render.trap + 1) % TRAP_TYPES;
+}
+
+/* Function that places the color pixel in the image according to the
+ escape value. Fallback for images that are not 32 bits per pixel: the
+ first bytes of the packed word are copied. */
+void	put_pixel(t_fractol *fractol, int x, int y, double value)
+{
+	uint32_t	px;
+
+	px = 0;
+	if (value < fractol->fractal.iteration)
+		px = fractol->palette.lut[(int)(value * fractol->palette.steps)];
+	ft_put_word(fractol, x, y, px);
+}
+
+/* Stores a pixel word (already in image byte order) at (x, y), whatever
+ the depth of the image. */
+void	ft_put_word(t_fractol *f, int x, int y, uint32_t px)
+{
+	char	*dst;
+	int		bytes_per_pixel;
+
+	bytes_per_pixel = f->mlx.bits_per_pixel / 8;
+	if (bytes_per_pixel > 4)
+		bytes_per_pixel = 4;
+	dst = f->mlx.addr + y * f->mlx.line_length + x * bytes_per_pixel;
+	ft_memcpy(dst, &px, bytes_per_pixel);
+}
@@ -1,4 +1,12 @@
 #include "../includes/fractol.h"
+
+/* Pan by hand: stops a guided zoom (nucleus.c) before moving. */
+static void	ft_pan(t_fractol *f, long double dx, long double dy)
+{
+	ft_nucleus_cancel(f);
+	ft_view_move(f, dx, dy);
+}
+
 /*
 * FUNZIONE KEY - Gestisce gli input da tastiera per controllare il frattale
 * 
@@ -24,6 +32,10 @@
 * - Termina immediatamente il programma
 * - Equivale a chiudere la finestra
 * 
+* G_KEY:
+* - Cerca il minibrot piu' vicino al centro e ci zooma sopra (nucleus.c)
+* - Premuto di nuovo ferma la ricerca o lo zoom guidato
+* 
 * SPACE_KEY (49):
 * - Cambia i colori del frattale chiamando random_colors()
 * - Genera una nuova palette di colori per il rendering
@@ -54,9 +66,8 @@
 *    - ESC: termina il programma
 *    - SPACE: cambia i colori
 *    - Tasti direzionali: sposta la vista nel piano complesso
-* 3. Resetta le coordinate di rendering (height = 0, width = 0)
-* 4. Ridisegna il frattale con le nuove impostazioni
-* 5. Restituisce 0 (richiesto da MiniLibX)
+* 3. Fa ripartire il frame con le nuove impostazioni (ft_draw)
+* 4. Restituisce 0 (richiesto da MiniLibX)
 * 
 * CONCETTO DI MOVIMENTO NEL PIANO COMPLESSO:
 * - Il frattale è visualizzato in una finestra di dimensioni fisse
@@ -72,10 +83,9 @@
 * - La divisione per scale rende il movimento proporzionale allo zoom
 * - Risultato: movimento più preciso quando si è zoomati
 * 
-* RESET DELLE COORDINATE:
-* - height = 0 e width = 0: riparte il rendering dall'angolo in alto a sinistra
-* - Necessario per ridisegnare correttamente il frattale dopo le modifiche
-* - ft_draw() userà questi valori come punto di partenza
+* RIPARTENZA DEL FRAME:
+* - ft_draw() riporta il rendering alla prima riga
+* - Le righe vengono poi calcolate dal frame hook (ft_render_frame)
 * 
 * INTEGRAZIONE CON MINILIBX:
 * - Questa funzione è registrata come callback con mlx_key_hook()
@@ -89,63 +99,106 @@ int	key(int key, t_fractol *fractol)
 		clean_exit(fractol, 0);
 	else if (key == SPACE_KEY)
 		random_colors(fractol);
+	else if (key == C_KEY)
+		toggle_smooth(fractol);
+	else if (key == H_KEY)
+		toggle_histogram(fractol);
+	else if (key == X_KEY)
+		toggle_antialias(fractol);
+	else if (key == F_KEY)
+		toggle_fullscreen(fractol);
+	else if (key == P_KEY)
+		toggle_preview(fractol);
+	else if (key == N_KEY)
+		next_power(fractol);
+	else if (key == J_KEY)
+		toggle_jit(fractol);
+	else if (key == E_KEY)
+		toggle_distance(fractol);
+	else if (key == B_KEY)
+		toggle_buddha(fractol);
+	else if (key == T_KEY)
+		next_trap(fractol);
+	else if (key == G_KEY)
+		toggle_nucleus(fractol);
 	else if (key == W_KEY || key == UP_ARROW)
-		fractol->fractal.offset_y += 10 / fractol->fractal.scale;  // Move up
+		ft_pan(fractol, 0, 10 / fractol->fractal.scale);  // Move up
 	else if (key == A_KEY || key == LEFT_ARROW)
-		fractol->fractal.offset_x -= 10 / fractol->fractal.scale;  // Move left
+		ft_pan(fractol, -10 / fractol->fractal.scale, 0);  // Move left
 	else if (key == S_KEY || key == DOWN_ARROW)
-		fractol->fractal.offset_y -= 10 / fractol->fractal.scale;  // Move down
+		ft_pan(fractol, 0, -10 / fractol->fractal.scale);  // Move down
 	else if (key == D_KEY || key == RIGHT_ARROW)
-		fractol->fractal.offset_x += 10 / fractol->fractal.scale;  // Move right
-	
-	// Reset rendering coordinates and redraw
-	fractol->fractal.pixel_x = 0;
-	fractol->fractal.pixel_y = 0;
+		ft_pan(fractol, 10 / fractol->fractal.scale, 0);  // Move right
 	ft_draw(fractol);
 	return (0);
 }
 
+/* Moves the exact center of the view (the t_big in fractal.center) by
+ (dx, dy) and derives the long double offsets from it. The steps are a few
+ pixels, so long double is plenty for them even where it is not for the
+ center. */
+void	ft_view_move(t_fractol *f, long double dx, long double dy)
+{
+	t_big	d;
+
+	ft_big_from_ld(&d, dx, BIG_LIMBS);
+	ft_big_add(&f->fractal.center[0], &f->fractal.center[0], &d);
+	ft_big_from_ld(&d, dy, BIG_LIMBS);
+	ft_big_add(&f->fractal.center[1], &f->fractal.center[1], &d);
+	f->fractal.offset_x = ft_big_to_ld(&f->fractal.center[0])
+		- f->mlx.width / 2.0L / f->fractal.scale;
+	f->fractal.offset_y = ft_big_to_ld(&f->fractal.center[1])
+		- f->mlx.height / 2.0L / f->fractal.scale;
+}
+
+/* Exact center from the offsets, once the view is placed from scratch. */
+void	ft_view_reset(t_fractol *f)
+{
+	ft_big_from_ld(&f->fractal.center[0], f->fractal.offset_x
+		+ f->mlx.width / 2.0L / f->fractal.scale, BIG_LIMBS);
+	ft_big_from_ld(&f->fractal.center[1], f->fractal.offset_y
+		+ f->mlx.height / 2.0L / f->fractal.scale, BIG_LIMBS);
+}
+
 /* Function that zooms in by increasing the scale and keeping the mouse position fixed */
-// 1. (double mouse_x) Save current mouse position in complex plane
+// 1. Save the current scale
 // 2. Update the scale
-// 3. Calculate new offsets to keep the mouse position fixed
+// 3. Move the center so the point under the mouse stays fixed
 // 4. Increase iterations for more detail
 void	zoom_in(int x, int y, t_fractol *f)
 {
-    if (f->fractal.scale >= SCALE_LIMIT)
+    if (f->fractal.scale >= ft_scale_limit(f))
         return;
 
-    double mouse_x = (double)x / f->fractal.scale + f->fractal.offset_x;
-    double mouse_y = (double)y / f->fractal.scale + f->fractal.offset_y;
+    long double old = f->fractal.scale;
 
     f->fractal.scale *= SCALE_PRS;
-    
-    f->fractal.offset_x = mouse_x - ((double)x / f->fractal.scale);
-    f->fractal.offset_y = mouse_y - ((double)y / f->fractal.scale);
-    
+
+    ft_view_move(f, (x - f->mlx.width / 2.0L) * (1 / old - 1 / f->fractal.scale),
+        (y - f->mlx.height / 2.0L) * (1 / old - 1 / f->fractal.scale));
+
     f->fractal.iteration += SCALE_ITER;
 }
 
 /* Zoom out from the current mouse position */
-// 1. Save current mouse position in complex plane
+// 1. Save the current scale
 // 2. Update the scale (decrease it)
-// 3. Calculate new offsets to keep the mouse position fixed
+// 3. Move the center so the point under the mouse stays fixed
 // 4. Decrease iterations for better performance
 void zoom_out(int x, int y, t_fractol *f)
 {
     if (f->fractal.scale <= 1.0)  // Prevent zooming out too much
         return;
 
-    // 1. Save current mouse position in complex plane
-    double mouse_x = (double)x / f->fractal.scale + f->fractal.offset_x;
-    double mouse_y = (double)y / f->fractal.scale + f->fractal.offset_y;
+    // 1. Save the current scale
+    long double old = f->fractal.scale;
 
     // 2. Update the scale (decrease it)
     f->fractal.scale /= SCALE_PRS;
-    
-    // 3. Calculate new offsets to keep the mouse position fixed
-    f->fractal.offset_x = mouse_x - ((double)x / f->fractal.scale);
-    f->fractal.offset_y = mouse_y - ((double)y / f->fractal.scale);
+
+    // 3. Move the center so the point under the mouse stays fixed
+    ft_view_move(f, (x - f->mlx.width / 2.0L) * (1 / old - 1 / f->fractal.scale),
+        (y - f->mlx.height / 2.0L) * (1 / old - 1 / f->fractal.scale));
     
     // 4. Decrease iterations for better performance
     if (f->fractal.iteration > 50) {  // Keep a minimum iteration count
@@ -163,6 +216,13 @@ int	mouse(int mouse, int x, int y, t_fractol *fractol)
 	long			current_time;
 	int				throttle_ms;
 	
+	if (mouse == LEFT_CLICK && ft_preview_active(fractol))
+	{
+		ft_nucleus_cancel(fractol);
+		preview_open(x, y, fractol);
+		ft_draw(fractol);
+		return (0);
+	}
 	gettimeofday(&tv, NULL);
 	current_time = tv.tv_sec * 1000 + tv.tv_usec / 1000;
 	
@@ -173,14 +233,14 @@ int	mouse(int mouse, int x, int y, t_fractol *fractol)
 	if (current_time - fractol->last_zoom_time < throttle_ms)
 		return (0);
 	
+	if (mouse == DOWN_SCROLL || mouse == UP_SCROLL)
+		ft_nucleus_cancel(fractol);
 	if (mouse == DOWN_SCROLL)
 		zoom_in(x, y, fractol);
 	if (mouse == UP_SCROLL)
 		zoom_out(x, y, fractol);
 	
 	fractol->last_zoom_time = current_time;
-	fractol->fractal.pixel_y = 0;
-	fractol->fractal.pixel_x = 0;
 	ft_draw(fractol);
 	return (0);
 }
@@ -201,6 +261,24 @@ void	clean_exit(t_fractol *f, int exit_code)
 {
 	if (f)
 	{
+		ft_nucleus_stop(f);
+		ft_pool_destroy(&f->pool);
+		ft_jit_unload(f);
+		free(f->palette.lut);
+		free(f->render.values);
+		free(f->render.dist);
+		free(f->render.glitch);
+		ft_glitch_free(f);
+		ft_tiles_free(f);
+		free(f->buddha.counts);
+		free(f->buddha.max);
+		free(f->orbit.re);
+		free(f->orbit.im);
+		free(f->orbit.bla);
+		free(f->orbit.big);
+		free(f->histo.counts);
+		free(f->histo.cdf);
+		free(f->preview.values);
 		if (f->mlx.img && f->mlx.mlx)
 			mlx_destroy_image(f->mlx.mlx, f->mlx.img);
 		if (f->mlx.win && f->mlx.mlx)
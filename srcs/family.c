@@ -0,0 +1,109 @@
+#include "../includes/engine.h"
+
+/*
+ * FAMIGLIA MULTIBROT E BURNING SHIP
+ *
+ * Multibrot (tipo 5): z = z^n + c con z che parte da 0, per n intero da 2
+ * a 8 (tasto N). Ha n - 1 "bulbi" principali disposti con simmetria di
+ * ordine n - 1; per n = 2 e' il Mandelbrot. Ogni potenza ha il suo kernel:
+ * la potenza e' una costante e zstep_d/zstep_f la srotolano in quadrati e
+ * prodotti complessi (ad esempio z^5 = (z²)² z), niente pow().
+ *
+ * Le altre tre sono varianti di grado 2 del Mandelbrot:
+ * - Burning Ship (tipo 6): z = (|Re z| + i|Im z|)² + c, la "nave in fiamme"
+ * - Tricorn (tipo 7): z = conj(z)² + c, detto anche Mandelbar
+ * - Celtic (tipo 8): z = |Re(z²)| + i Im(z²) + c
+ *
+ * Tutti passano dallo stesso motore vettoriale (engine.h) e dallo stesso
+ * registro (registry.c) dei quattro frattali originali.
+ */
+
+void	multibrot3_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_MANDEL, 3);
+}
+
+void	multibrot3_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_MANDEL, 3);
+}
+
+void	multibrot4_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_MANDEL, 4);
+}
+
+void	multibrot4_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_MANDEL, 4);
+}
+
+void	multibrot5_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_MANDEL, 5);
+}
+
+void	multibrot5_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_MANDEL, 5);
+}
+
+void	multibrot6_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_MANDEL, 6);
+}
+
+void	multibrot6_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_MANDEL, 6);
+}
+
+void	multibrot7_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_MANDEL, 7);
+}
+
+void	multibrot7_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_MANDEL, 7);
+}
+
+void	multibrot8_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_MANDEL, 8);
+}
+
+void	multibrot8_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_MANDEL, 8);
+}
+
+void	ship_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_SHIP, 2);
+}
+
+void	ship_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_SHIP, 2);
+}
+
+void	tricorn_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_TRICORN, 2);
+}
+
+void	tricorn_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_TRICORN, 2);
+}
+
+void	celtic_d(const t_frame *fr, const t_row *row)
+{
+	row_d(fr, row, KMODE_CELTIC, 2);
+}
+
+void	celtic_f(const t_frame *fr, const t_row *row)
+{
+	row_f(fr, row, KMODE_CELTIC, 2);
+}
@@ -0,0 +1,316 @@
+#include "../includes/fractol.h"
+
+/*
+ * LINGUAGGIO DELLE FORMULE - Compila la formula di iterazione scritta
+ * dall'utente (ad esempio "z*z*z + c*sin(z)") in un bytecode a registri
+ * che la VM (vm.c) esegue su blocchi di pixel.
+ *
+ * GRAMMATICA:
+ *   formula := [ "z" "=" ] expr
+ *   expr    := term { ("+" | "-") term }
+ *   term    := unary { ("*" | "/") unary }
+ *   unary   := "-" unary | power
+ *   power   := primary [ "^" intero ]
+ *   primary := numero [ "i" ] | "z" | "c" | "i" | "(" expr ")"
+ *            | funzione "(" expr ")"
+ *   funzione: sin cos exp log conj abs sqr
+ *   (abs e' |Re z| + i|Im z|, come nel Burning Ship; sqr e' z²)
+ *
+ * REGISTRI:
+ * - r0 contiene z, r1 contiene c (la posizione del pixel)
+ * - i risultati intermedi usano i registri come una pila: ogni operando
+ *   va nel primo registro libero, l'operazione scrive nel registro del
+ *   primo operando. Il risultato finale e' in FORMULA_OUT (r2).
+ *
+ * Il grado della formula in z (z*z*z ha grado 3) viene stimato durante
+ * la compilazione e serve solo alla colorazione smooth.
+ */
+
+static int	ft_parse_expr(t_parser *p);
+
+static int	ft_parse_error(t_parser *p, const char *msg)
+{
+	if (!p->error)
+	{
+		p->error = msg;
+		p->column = p->pos + 1;
+	}
+	return (-1);
+}
+
+static void	ft_skip_spaces(t_parser *p)
+{
+	while (p->src[p->pos] == ' ' || p->src[p->pos] == '\t')
+		p->pos++;
+}
+
+/* Appends an instruction writing register dst; returns dst or -1. */
+static int	ft_emit(t_parser *p, int op, int dst, int src)
+{
+	t_insn	*insn;
+
+	if (p->prog->count >= FORMULA_CODE)
+		return (ft_parse_error(p, "formula too long"));
+	if (dst >= FORMULA_REGS)
+		return (ft_parse_error(p, "formula nested too deeply"));
+	insn = &p->prog->code[p->prog->count++];
+	ft_bzero(insn, sizeof(*insn));
+	insn->op = op;
+	insn->dst = dst;
+	insn->src = src;
+	if (dst >= p->prog->regs)
+		p->prog->regs = dst + 1;
+	return (dst);
+}
+
+static double	ft_parse_number(t_parser *p)
+{
+	double	value;
+	double	scale;
+
+	value = 0;
+	while (ft_isdigit(p->src[p->pos]))
+		value = value * 10 + (p->src[p->pos++] - '0');
+	if (p->src[p->pos] != '.')
+		return (value);
+	p->pos++;
+	scale = 1;
+	while (ft_isdigit(p->src[p->pos]))
+	{
+		scale /= 10;
+		value += (p->src[p->pos++] - '0') * scale;
+	}
+	return (value);
+}
+
+static int	ft_parse_const(t_parser *p, double re, double im)
+{
+	int	dst;
+
+	dst = ft_emit(p, OP_CONST, p->top, 0);
+	if (dst < 0)
+		return (-1);
+	p->prog->code[p->prog->count - 1].re = re;
+	p->prog->code[p->prog->count - 1].im = im;
+	p->degree[dst] = 0;
+	return (dst);
+}
+
+static const char	*g_functions[] = {
+	"sin", "cos", "exp", "log", "conj", "abs", "sqr", NULL
+};
+
+/* Function call: the argument lands in the current top register and the
+ function is applied in place. */
+static int	ft_parse_call(t_parser *p, int fn)
+{
+	int	dst;
+
+	p->pos += ft_strlen(g_functions[fn]);
+	ft_skip_spaces(p);
+	if (p->src[p->pos] != '(')
+		return (ft_parse_error(p, "expected '(' after function name"));
+	p->pos++;
+	dst = ft_parse_expr(p);
+	ft_skip_spaces(p);
+	if (dst < 0 || p->src[p->pos] != ')')
+		return (ft_parse_error(p, "expected ')'"));
+	p->pos++;
+	if (ft_emit(p, OP_SIN + fn, dst, dst) < 0)
+		return (-1);
+	if (OP_SIN + fn == OP_SQR)
+		p->degree[dst] *= 2;
+	return (dst);
+}
+
+static int	ft_parse_name(t_parser *p)
+{
+	int	fn;
+	int	len;
+
+	fn = -1;
+	while (g_functions[++fn])
+	{
+		len = ft_strlen(g_functions[fn]);
+		if (!ft_strncmp(p->src + p->pos, g_functions[fn], len)
+			&& !ft_isalpha(p->src[p->pos + len]))
+			return (ft_parse_call(p, fn));
+	}
+	if (ft_isalpha(p->src[p->pos + 1])
+		|| !ft_strchr("zci", p->src[p->pos]))
+		return (ft_parse_error(p, "unknown name"));
+	if (p->src[p->pos++] == 'i')
+		return (ft_parse_const(p, 0, 1));
+	if (ft_emit(p, OP_MOV, p->top, p->src[p->pos - 1] == 'c') < 0)
+		return (-1);
+	p->degree[p->top] = (p->src[p->pos - 1] == 'z');
+	return (p->top);
+}
+
+static int	ft_parse_primary(t_parser *p)
+{
+	double	value;
+	int		dst;
+
+	ft_skip_spaces(p);
+	if (ft_isdigit(p->src[p->pos]) || p->src[p->pos] == '.')
+	{
+		value = ft_parse_number(p);
+		if (p->src[p->pos] == 'i' && !ft_isalpha(p->src[p->pos + 1]))
+		{
+			p->pos++;
+			return (ft_parse_const(p, 0, value));
+		}
+		return (ft_parse_const(p, value, 0));
+	}
+	if (ft_isalpha(p->src[p->pos]))
+		return (ft_parse_name(p));
+	if (p->src[p->pos] != '(')
+		return (ft_parse_error(p, "expected a number, z, c, i or '('"));
+	p->pos++;
+	dst = ft_parse_expr(p);
+	ft_skip_spaces(p);
+	if (dst < 0 || p->src[p->pos] != ')')
+		return (ft_parse_error(p, "expected ')'"));
+	p->pos++;
+	return (dst);
+}
+
+/* power := primary [ "^" integer ], integer exponents from 1 to 64. */
+static int	ft_parse_power(t_parser *p)
+{
+	int	dst;
+	int	n;
+
+	dst = ft_parse_primary(p);
+	ft_skip_spaces(p);
+	if (dst < 0 || p->src[p->pos] != '^')
+		return (dst);
+	p->pos++;
+	ft_skip_spaces(p);
+	if (!ft_isdigit(p->src[p->pos]))
+		return (ft_parse_error(p, "exponent must be an integer"));
+	n = 0;
+	while (ft_isdigit(p->src[p->pos]) && n <= 64)
+		n = n * 10 + (p->src[p->pos++] - '0');
+	if (n < 1 || n > 64)
+		return (ft_parse_error(p, "exponent must be between 1 and 64"));
+	if (ft_emit(p, OP_POW, dst, dst) < 0)
+		return (-1);
+	p->prog->code[p->prog->count - 1].n = n;
+	p->degree[dst] *= n;
+	return (dst);
+}
+
+static int	ft_parse_unary(t_parser *p)
+{
+	int	dst;
+
+	ft_skip_spaces(p);
+	if (p->src[p->pos] != '-')
+		return (ft_parse_power(p));
+	p->pos++;
+	dst = ft_parse_unary(p);
+	if (dst < 0)
+		return (-1);
+	return (ft_emit(p, OP_NEG, dst, dst));
+}
+
+/* Binary operator: the right operand goes one register above the left. */
+static int	ft_parse_binary(t_parser *p, int op, int (*operand)(t_parser *))
+{
+	int	dst;
+	int	rhs;
+
+	dst = p->top++;
+	rhs = operand(p);
+	p->top--;
+	if (rhs < 0 || ft_emit(p, op, dst, rhs) < 0)
+		return (-1);
+	if (op == OP_MUL)
+		p->degree[dst] += p->degree[rhs];
+	else if (op == OP_DIV)
+		p->degree[dst] -= p->degree[rhs];
+	else if (p->degree[rhs] > p->degree[dst])
+		p->degree[dst] = p->degree[rhs];
+	return (dst);
+}
+
+static int	ft_parse_term(t_parser *p)
+{
+	int	dst;
+
+	dst = ft_parse_unary(p);
+	while (dst >= 0)
+	{
+		ft_skip_spaces(p);
+		if (p->src[p->pos] != '*' && p->src[p->pos] != '/')
+			return (dst);
+		p->pos++;
+		if (p->src[p->pos - 1] == '*')
+			dst = ft_parse_binary(p, OP_MUL, ft_parse_unary);
+		else
+			dst = ft_parse_binary(p, OP_DIV, ft_parse_unary);
+	}
+	return (dst);
+}
+
+static int	ft_parse_expr(t_parser *p)
+{
+	int	dst;
+
+	dst = ft_parse_term(p);
+	while (dst >= 0)
+	{
+		ft_skip_spaces(p);
+		if (p->src[p->pos] != '+' && p->src[p->pos] != '-')
+			return (dst);
+		p->pos++;
+		if (p->src[p->pos - 1] == '+')
+			dst = ft_parse_binary(p, OP_ADD, ft_parse_term);
+		else
+			dst = ft_parse_binary(p, OP_SUB, ft_parse_term);
+	}
+	return (dst);
+}
+
+/* Compiles src into prog. On error prints the reason and the column to
+ stderr and returns 1. */
+int	ft_formula_compile(t_program *prog, const char *src)
+{
+	t_parser	p;
+
+	ft_bzero(prog, sizeof(*prog));
+	ft_bzero(&p, sizeof(p));
+	p.src = src;
+	p.prog = prog;
+	p.top = FORMULA_OUT;
+	ft_skip_spaces(&p);
+	if (src[p.pos] == 'z')
+	{
+		p.pos++;
+		ft_skip_spaces(&p);
+		if (src[p.pos] != '=')
+			p.pos = 0;
+		p.pos += (src[p.pos] == '=');
+	}
+	if (ft_parse_expr(&p) >= 0)
+	{
+		ft_skip_spaces(&p);
+		if (src[p.pos])
+			ft_parse_error(&p, "unexpected character");
+	}
+	if (!p.error)
+	{
+		prog->degree = p.degree[FORMULA_OUT];
+		if (prog->degree < 2)
+			prog->degree = 2;
+		return (0);
+	}
+	ft_putstr_fd("\033[31mError: formula: ", 2);
+	ft_putstr_fd((char *)p.error, 2);
+	ft_putstr_fd(" at column ", 2);
+	ft_putnbr_fd(p.column, 2);
+	ft_putstr_fd("\e[0m\n", 2);
+	return (1);
+}
@@ -0,0 +1,322 @@
+#include "../includes/fractol.h"
+
+/*
+ * RIFERIMENTI MULTIPLI - Con un solo riferimento i pixel la cui orbita
+ * passa vicino a 0 molto piu' di quella di riferimento perdono le cifre
+ * di d e vengono sbagliati (glitch): il kernel li segna in
+ * render.glitch (criterio di Pauldelbrot, perturb.c) e, a frame finito,
+ * questo passo li corregge a giri:
+ *
+ * - la vista e' divisa in tile di GLITCH_TILE pixel; per ogni tile si
+ *   contano i pixel segnati e il loro baricentro
+ * - ogni tile con glitch sceglie il riferimento migliore tra quelli gia'
+ *   piazzati: il piu' vicino al suo baricentro entro GLITCH_REUSE pixel,
+ *   escluso quello con cui e' appena stato calcolato. Se non ce n'e' uno
+ *   si piazza un nuovo riferimento sul pixel segnato piu' vicino al
+ *   baricentro, dove l'orbita e' per forza diversa da quella vecchia; le
+ *   tile dopo, nello stesso giro, possono gia' sceglierlo, cosi' una
+ *   macchia di glitch su piu' tile prende un solo riferimento. Le tile
+ *   piu' piene scelgono per prime, cosi' i pixel isolati non consumano i
+ *   riferimenti delle macchie grandi
+ * - i riferimenti nuovi si calcolano insieme, uno per thread del pool
+ *   (in virgola fissa, con la tabella BLA ma senza serie), poi le tile si
+ *   ricalcolano in parallelo, ognuna col suo riferimento; dei pixel si
+ *   tengono solo quelli che erano segnati, ora segnati o no dal nuovo
+ * - si ripete finche' non resta nessun glitch, per al massimo
+ *   GLITCH_ROUNDS giri e GLITCH_REFS riferimenti: quel che resta tiene il
+ *   valore del primo calcolo, come prima di questo passo
+ * - in render.glitch un pixel corretto vale GLITCH_FIXED + k, k il
+ *   riferimento che l'ha corretto: l'anti-aliasing (antialias.c)
+ *   ricampiona il pixel con quello e non con il riferimento principale,
+ *   che lo sbaglierebbe di nuovo
+ *
+ * Un giro per volta gira dal frame hook, tra le righe e l'istogramma.
+ */
+
+int	ft_glitch_pending(t_fractol *f)
+{
+	return (f->frame.orbit != NULL && f->refs.pending);
+}
+
+/* First round: every tile of the view to scan, no extra reference yet. */
+static int	ft_glitch_start(t_fractol *f)
+{
+	t_refs	*r;
+	int		tx;
+	int		n;
+	int		k;
+
+	r = &f->refs;
+	tx = (f->mlx.width + GLITCH_TILE - 1) / GLITCH_TILE;
+	n = tx * ((f->mlx.height + GLITCH_TILE - 1) / GLITCH_TILE);
+	if (n > r->cap)
+	{
+		free(r->tiles);
+		free(r->todo);
+		r->tiles = malloc(sizeof(t_tile) * n);
+		r->todo = malloc(sizeof(int) * n);
+		r->cap = n * (r->tiles && r->todo);
+		if (!r->cap)
+			return (1);
+	}
+	k = -1;
+	while (++k < n)
+	{
+		r->tiles[k].x = k % tx * GLITCH_TILE;
+		r->tiles[k].y = k / tx * GLITCH_TILE;
+		r->tiles[k].ref = -1;
+		r->todo[k] = k;
+	}
+	r->left = n;
+	r->count = 0;
+	return (0);
+}
+
+/* Pool job: glitched pixels of tile todo[index] and their centroid. */
+static void	ft_glitch_scan(void *arg, int index, int thread)
+{
+	t_fractol		*f;
+	t_tile			*t;
+	unsigned char	*g;
+	int				x;
+	int				y;
+	int				n;
+
+	(void)thread;
+	f = arg;
+	t = &f->refs.tiles[f->refs.todo[index]];
+	t->count = 0;
+	t->cx = 0;
+	t->cy = 0;
+	y = t->y - 1;
+	while (++y < t->y + GLITCH_TILE && y < f->mlx.height)
+	{
+		g = f->render.glitch + (size_t)y * f->mlx.width;
+		x = t->x - 1;
+		while (++x < t->x + GLITCH_TILE && x < f->mlx.width)
+		{
+			n = (g[x] == 1);
+			t->count += n;
+			t->cx += n * x;
+			t->cy += n * y;
+		}
+	}
+	if (!t->count)
+		return ;
+	t->cx /= t->count;
+	t->cy /= t->count;
+}
+
+/* Glitched pixel of t nearest to its centroid: the new reference. */
+static void	ft_glitch_place(t_fractol *f, const t_tile *t, t_orbit *o)
+{
+	double	best;
+	double	d;
+	int		x;
+	int		y;
+
+	best = INFINITY;
+	y = t->y - 1;
+	while (++y < t->y + GLITCH_TILE && y < f->mlx.height)
+	{
+		x = t->x - 1;
+		while (++x < t->x + GLITCH_TILE && x < f->mlx.width)
+		{
+			d = (x - t->cx) * (x - t->cx) + (y - t->cy) * (y - t->cy);
+			if (f->render.glitch[(size_t)y * f->mlx.width + x] != 1
+				|| d >= best)
+				continue ;
+			best = d;
+			o->px = x;
+			o->py = y;
+		}
+	}
+}
+
+/* Reference of every glitched tile: the nearest one within GLITCH_REUSE
+ pixels other than the one it failed with, or a new one, or the nearest
+ at any distance once GLITCH_REFS are placed. */
+static void	ft_glitch_assign(t_fractol *f, t_tile *t)
+{
+	t_refs	*r;
+	double	best[2];
+	double	d;
+	int		k;
+
+	r = &f->refs;
+	best[0] = INFINITY;
+	best[1] = -1;
+	k = -1;
+	while (++k < r->count)
+	{
+		d = (r->orbit[k].px - t->cx) * (r->orbit[k].px - t->cx)
+			+ (r->orbit[k].py - t->cy) * (r->orbit[k].py - t->cy);
+		if (k != t->ref && d < best[0])
+		{
+			best[0] = d;
+			best[1] = k;
+		}
+	}
+	if (best[0] >= GLITCH_REUSE * GLITCH_REUSE && r->count < GLITCH_REFS)
+	{
+		ft_glitch_place(f, t, &r->orbit[r->count]);
+		best[1] = r->count++;
+	}
+	t->ref = best[1];
+	if (t->ref < 0)
+		t->count = 0;
+}
+
+/* Pool job: reference added + index. With at most half as many new
+ references as CPUs each one gets its partner thread. */
+static void	ft_glitch_reference(void *arg, int index, int thread)
+{
+	t_fractol	*f;
+	t_refs		*r;
+	int			k;
+
+	(void)thread;
+	f = arg;
+	r = &f->refs;
+	k = r->added + index;
+	r->frame[k] = f->frame;
+	r->frame[k].orbit = NULL;
+	if (ft_orbit_extra(f, &r->orbit[k], r->orbit[k].px, r->orbit[k].py,
+			2 * (r->count - r->added) <= ft_pool_size(&f->pool)) == 0)
+		r->frame[k].orbit = &r->orbit[k];
+}
+
+/* Span of row y of tile t from its first to its last glitched pixel, in
+ x[0] .. x[1]; empty when x[0] == x[1]. */
+static void	ft_glitch_span(t_fractol *f, const t_tile *t, int y, int *x)
+{
+	unsigned char	*g;
+	int				end;
+
+	g = f->render.glitch + (size_t)y * f->mlx.width;
+	end = t->x + GLITCH_TILE;
+	if (end > f->mlx.width)
+		end = f->mlx.width;
+	x[0] = t->x;
+	while (x[0] < end && g[x[0]] != 1)
+		x[0]++;
+	x[1] = end;
+	while (x[1] > x[0] && g[x[1] - 1] != 1)
+		x[1]--;
+}
+
+/* Pool job: tile todo[index] again with its reference, only the spans
+ with glitched pixels, keeping only the pixels that were glitched. */
+static void	ft_glitch_tile(void *arg, int index, int thread)
+{
+	t_fractol		*f;
+	t_tile			*t;
+	t_row			row;
+	float			out[2][GLITCH_TILE];
+	unsigned char	g[GLITCH_TILE];
+	int				x[3];
+	int				y;
+
+	(void)thread;
+	f = arg;
+	t = &f->refs.tiles[f->refs.todo[index]];
+	if (!t->count || !f->refs.frame[t->ref].orbit)
+		return ;
+	row.out = out[0];
+	row.dist = NULL;
+	if (f->frame.de)
+		row.dist = out[1];
+	row.glitch = g;
+	y = t->y - 1;
+	while (++y < t->y + GLITCH_TILE && y < f->mlx.height)
+	{
+		ft_glitch_span(f, t, y, x);
+		row.count = x[1] - x[0];
+		if (!row.count)
+			continue ;
+		ft_frame_row(&f->refs.frame[t->ref], x[0], y, &row);
+		x[2] = -1;
+		while (++x[2] < row.count)
+		{
+			if (f->render.glitch[(size_t)y * f->mlx.width + x[0] + x[2]] != 1)
+				continue ;
+			f->render.values[(size_t)y * f->mlx.width + x[0] + x[2]]
+				= out[0][x[2]];
+			if (row.dist)
+				f->render.dist[(size_t)y * f->mlx.width + x[0] + x[2]]
+					= out[1][x[2]];
+			f->render.glitch[(size_t)y * f->mlx.width + x[0] + x[2]]
+				= g[x[2]] + !g[x[2]] * (GLITCH_FIXED + t->ref);
+		}
+		ft_paint_span(f, y, x[0], x[1]);
+	}
+}
+
+/* Tiles left, most glitched first: the large patches get the new
+ references before the lone pixels run out of them. */
+static void	ft_glitch_sort(t_refs *r)
+{
+	int	k;
+	int	j;
+	int	t;
+
+	k = 0;
+	while (++k < r->left)
+	{
+		t = r->todo[k];
+		j = k;
+		while (--j >= 0 && r->tiles[r->todo[j]].count < r->tiles[t].count)
+			r->todo[j + 1] = r->todo[j];
+		r->todo[j + 1] = t;
+	}
+}
+
+/* One correction round: scan the tiles left, stop if they are clean or
+ out of rounds, else place and compute the references and render the
+ tiles again. */
+void	ft_glitch_round(t_fractol *f)
+{
+	t_refs	*r;
+	int		k;
+	int		n;
+
+	r = &f->refs;
+	if (r->round == 0 && ft_glitch_start(f) != 0)
+		r->pending = 0;
+	if (!r->pending)
+		return ;
+	ft_pool_run(&f->pool, ft_glitch_scan, f, r->left);
+	n = 0;
+	k = -1;
+	while (++k < r->left)
+		if (r->tiles[r->todo[k]].count)
+			r->todo[n++] = r->todo[k];
+	r->left = n;
+	r->pending = (n > 0 && r->round < GLITCH_ROUNDS);
+	if (!r->pending)
+		return ;
+	ft_glitch_sort(r);
+	r->added = r->count;
+	k = -1;
+	while (++k < r->left)
+		ft_glitch_assign(f, &r->tiles[r->todo[k]]);
+	ft_pool_run(&f->pool, ft_glitch_reference, f, r->count - r->added);
+	ft_pool_run(&f->pool, ft_glitch_tile, f, r->left);
+	r->round++;
+}
+
+void	ft_glitch_free(t_fractol *f)
+{
+	int	k;
+
+	k = -1;
+	while (++k < GLITCH_REFS)
+	{
+		free(f->refs.orbit[k].re);
+		free(f->refs.orbit[k].im);
+		free(f->refs.orbit[k].bla);
+		free(f->refs.orbit[k].big);
+	}
+	free(f->refs.tiles);
+	free(f->refs.todo);
+}
@@ -0,0 +1,133 @@
+#include "../includes/fractol.h"
+
+/*
+ * Colorazione a istogramma equalizzato. A frame finito si conta quanti
+ * pixel sono usciti a ogni profondita' (un istogramma parziale per thread,
+ * niente atomici nel ciclo caldo), si sommano i parziali e si costruisce
+ * la distribuzione cumulativa. Ogni pixel viene poi colorato con la sua
+ * posizione nella cumulativa invece che con la profondita' grezza: anche
+ * con migliaia di iterazioni la palette viene usata tutta.
+ */
+
+static void	ft_histo_count(void *arg, int y, int thread)
+{
+	t_fractol		*f;
+	unsigned int	*counts;
+	float			*values;
+	int				bins;
+	int				x;
+
+	f = arg;
+	bins = f->histo.bins;
+	counts = f->histo.counts + (size_t)thread * bins;
+	values = f->render.values + (size_t)y * f->mlx.width;
+	x = -1;
+	while (++x < f->mlx.width)
+		if (values[x] < bins)
+			counts[(int)values[x]]++;
+}
+
+static void	ft_histo_paint(void *arg, int y, int thread)
+{
+	t_fractol	*f;
+	uint32_t	*dst;
+	float		*values;
+	float		scale;
+	int			x;
+
+	(void)thread;
+	f = arg;
+	dst = (uint32_t *)(f->mlx.addr + y * f->mlx.line_length);
+	values = f->render.values + (size_t)y * f->mlx.width;
+	scale = (float)(f->histo.bins - 1) * f->palette.steps;
+	x = -1;
+	while (++x < f->mlx.width)
+	{
+		if (!(values[x] < f->histo.bins))
+			dst[x] = 0;
+		else
+			dst[x] = f->palette.lut[(int)(scale * (f->histo.cdf[(int)values[x]]
+						+ (values[x] - (int)values[x])
+						* (f->histo.cdf[(int)values[x] + 1]
+							- f->histo.cdf[(int)values[x]])))];
+		if (f->frame.de)
+			dst[x] = ft_de_shade(f, dst[x],
+					f->render.dist[(size_t)y * f->mlx.width + x]);
+	}
+}
+
+static int	ft_histo_alloc(t_fractol *f)
+{
+	int	threads;
+
+	threads = ft_pool_size(&f->pool);
+	if (f->histo.bins != f->fractal.iteration)
+	{
+		free(f->histo.counts);
+		free(f->histo.cdf);
+		f->histo.bins = f->fractal.iteration;
+		f->histo.counts = malloc(sizeof(unsigned int)
+				* (size_t)f->histo.bins * threads);
+		f->histo.cdf = malloc(sizeof(float) * (f->histo.bins + 1));
+		if (!f->histo.counts || !f->histo.cdf)
+		{
+			f->histo.bins = 0;
+			return (1);
+		}
+	}
+	ft_bzero(f->histo.counts, sizeof(unsigned int)
+		* (size_t)f->histo.bins * threads);
+	return (0);
+}
+
+/* Equalized escape value: position of value in the cumulative distribution
+ of the frame, scaled back to [0, iteration). */
+double	ft_histo_map(t_fractol *f, double value)
+{
+	int		n;
+	float	*cdf;
+
+	cdf = f->histo.cdf;
+	n = (int)value;
+	return ((cdf[n] + (value - n) * (cdf[n + 1] - cdf[n]))
+		* (f->histo.bins - 1));
+}
+
+/* Builds the histogram of the finished frame and repaints it equalized.
+ Needs 32 bits per pixel; other formats keep the linear colors. */
+void	ft_histogram_pass(t_fractol *f)
+{
+	unsigned long	total;
+	unsigned long	sum;
+	int				i;
+	int				t;
+
+	f->histo.ready = 0;
+	if (f->mlx.bits_per_pixel != 32 || ft_histo_alloc(f) != 0)
+		return ;
+	ft_pool_run(&f->pool, ft_histo_count, f, f->mlx.height);
+	total = 0;
+	i = -1;
+	while (++i < f->histo.bins)
+	{
+		t = 0;
+		while (++t < ft_pool_size(&f->pool))
+			f->histo.counts[i] += f->histo.counts[(size_t)t * f->histo.bins + i];
+		total += f->histo.counts[i];
+	}
+	sum = 0;
+	i = -1;
+	while (++i < f->histo.bins)
+	{
+		f->histo.cdf[i] = (float)sum / (total ? total : 1);
+		sum += f->histo.counts[i];
+	}
+	f->histo.cdf[f->histo.bins] = 1.0f;
+	f->histo.ready = 1;
+	ft_pool_run(&f->pool, ft_histo_paint, f, f->mlx.height);
+}
+
+void	toggle_histogram(t_fractol *f)
+{
+	f->histo.enabled = !f->histo.enabled;
+}
@@ -0,0 +1,268 @@
+#include "../includes/fractol.h"
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+/*
+ * JIT DELLE FORMULE - Per i render lunghi il bytecode della formula
+ * (formula.c) viene tradotto in sorgente C che usa lo stesso modello dei
+ * kernel nativi (row_step_d di engine.h, con csq_d, cmul_d, ...), compilato
+ * con il gcc locale in una libreria condivisa e caricato con dlopen.
+ *
+ * CACHE:
+ * - le librerie stanno in $XDG_CACHE_HOME/fractol (o ~/.cache/fractol)
+ * - il nome e' l'hash FNV-1a del sorgente generato, dei flag di
+ *   compilazione e degli header del motore: se cambia la formula o il
+ *   modello, cambia il file
+ * - se il file esiste gia' viene solo caricato, senza ricompilare
+ *
+ * Il JIT e' facoltativo (tasto J sul tipo formula): se manca il compilatore
+ * o qualcosa va storto resta la VM.
+ */
+
+static void	ft_jit_pow(FILE *out, int d, int n)
+{
+	int	first;
+
+	fprintf(out, "\tb[0] = r[%d][0];\n\tb[1] = r[%d][1];\n", d, d);
+	first = 1;
+	while (n)
+	{
+		if ((n & 1) && !first)
+			fprintf(out, "\tcmul_d(r[%d], b);\n", d);
+		if (n & 1)
+			first = 0;
+		n >>= 1;
+		if (n)
+			fprintf(out, "\tcsq_d(b);\n");
+		if (n && first)
+			fprintf(out, "\tr[%d][0] = b[0];\n\tr[%d][1] = b[1];\n", d, d);
+	}
+}
+
+/* One instruction as straight-line vector code. */
+static void	ft_jit_insn(FILE *out, const t_insn *in)
+{
+	const char	*assign;
+	int			d;
+
+	d = in->dst;
+	assign = "=";
+	if (in->op == OP_ADD || in->op == OP_SUB)
+		assign = (in->op == OP_ADD) ? "+=" : "-=";
+	if (in->op == OP_MOV || in->op == OP_ADD || in->op == OP_SUB)
+		fprintf(out, "\tr[%d][0] %s r[%d][0];\n\tr[%d][1] %s r[%d][1];\n",
+			d, assign, in->src, d, assign, in->src);
+	else if (in->op == OP_CONST)
+		fprintf(out, "\tr[%d][0] = (t_vd){0} + %a;\n"
+			"\tr[%d][1] = (t_vd){0} + %a;\n", d, in->re, d, in->im);
+	else if (in->op == OP_MUL || in->op == OP_DIV)
+		fprintf(out, "\t%s(r[%d], r[%d]);\n",
+			(in->op == OP_MUL) ? "cmul_d" : "cdiv_d", d, in->src);
+	else if (in->op == OP_SQR)
+		fprintf(out, "\tcsq_d(r[%d]);\n", d);
+	else if (in->op == OP_POW)
+		ft_jit_pow(out, d, in->n);
+	if (in->op == OP_NEG)
+		fprintf(out, "\tr[%d][0] = -r[%d][0];\n", d, d);
+	if (in->op == OP_NEG || in->op == OP_CONJ)
+		fprintf(out, "\tr[%d][1] = -r[%d][1];\n", d, d);
+	if (in->op == OP_ABS)
+		fprintf(out, "\tr[%d][0] = vd_select(r[%d][0] < 0, -r[%d][0], r[%d][0]);"
+			"\n\tr[%d][1] = vd_select(r[%d][1] < 0, -r[%d][1], r[%d][1]);\n",
+			d, d, d, d, d, d, d, d);
+	if (in->op >= OP_SIN && in->op <= OP_LOG)
+		fprintf(out, "\tl = -1;\n\twhile (++l < VD_LANES)\n"
+			"\t\tclane_d(%d, &r[%d][0][l], &r[%d][1][l]);\n", in->op, d, d);
+}
+
+/* C source of the kernel, in a malloc'd string. */
+static char	*ft_jit_source(const t_program *prog)
+{
+	FILE	*out;
+	char	*src;
+	size_t	len;
+	int		i;
+
+	src = NULL;
+	out = open_memstream(&src, &len);
+	if (!out)
+		return (NULL);
+	fprintf(out, "#include \"engine.h\"\n\n"
+		"static inline void\tjit_step(const t_vd *z, const t_vd *c, "
+		"t_vd *w)\n{\n\tt_vd\tr[%d][2];\n\tt_vd\tb[2];\n\tint\t\tl;\n\n"
+		"\t(void)b;\n\t(void)l;\n"
+		"\tr[0][0] = z[0];\n\tr[0][1] = z[1];\n"
+		"\tr[1][0] = c[0];\n\tr[1][1] = c[1];\n", prog->regs);
+	i = -1;
+	while (++i < prog->count)
+		ft_jit_insn(out, &prog->code[i]);
+	fprintf(out, "\tw[0] = r[%d][0];\n\tw[1] = r[%d][1];\n}\n\n"
+		"void\tjit_kernel(const t_frame *fr, const t_row *row)\n{\n"
+		"\trow_step_d(fr, row, jit_step);\n}\n", FORMULA_OUT, FORMULA_OUT);
+	fclose(out);
+	return (src);
+}
+
+static unsigned long	ft_fnv(unsigned long h, const char *s, size_t len)
+{
+	while (len--)
+		h = (h ^ (unsigned char)*s++) * 1099511628211UL;
+	return (h);
+}
+
+/* Hash of the source, the flags and the engine headers it includes. */
+static unsigned long	ft_jit_hash(const char *src)
+{
+	static const char	*headers[] = {"engine.h", "simd.h", "fractol.h", NULL};
+	char				path[JIT_PATH];
+	char				buf[4096];
+	unsigned long		h;
+	ssize_t				n;
+	int					fd;
+	int					i;
+
+	h = ft_fnv(14695981039346656037UL, src, ft_strlen(src));
+	h = ft_fnv(h, JIT_FLAGS, ft_strlen(JIT_FLAGS));
+	i = -1;
+	while (headers[++i])
+	{
+		snprintf(path, sizeof(path), "%s/%s", JIT_INCLUDE, headers[i]);
+		fd = open(path, O_RDONLY);
+		if (fd < 0)
+			continue ;
+		n = read(fd, buf, sizeof(buf));
+		while (n > 0)
+		{
+			h = ft_fnv(h, buf, n);
+			n = read(fd, buf, sizeof(buf));
+		}
+		close(fd);
+	}
+	return (h);
+}
+
+/* Runs JIT_CC on src into so, without a shell. */
+static int	ft_jit_cc(const char *src, const char *so)
+{
+	char	**flags;
+	char	*argv[JIT_ARGS];
+	pid_t	pid;
+	int		status;
+	int		i;
+
+	flags = ft_split(JIT_FLAGS, ' ');
+	if (!flags)
+		return (1);
+	argv[0] = JIT_CC;
+	i = 0;
+	while (flags[i] && i < JIT_ARGS - 8)
+	{
+		argv[i + 1] = flags[i];
+		i++;
+	}
+	argv[++i] = "-shared";
+	argv[++i] = "-fPIC";
+	argv[++i] = "-o";
+	argv[++i] = (char *)so;
+	argv[++i] = (char *)src;
+	argv[++i] = NULL;
+	pid = fork();
+	if (pid == 0)
+	{
+		execvp(argv[0], argv);
+		_exit(127);
+	}
+	status = -1;
+	if (pid > 0)
+		waitpid(pid, &status, 0);
+	i = -1;
+	while (flags[++i])
+		free(flags[i]);
+	free(flags);
+	return (pid <= 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0);
+}
+
+/* Writes the source next to the cache entry and compiles it. Source and
+ library get temporary names of this process and the library is renamed
+ into place, so a concurrent run neither overwrites the source being
+ compiled nor loads a half-written file. */
+static int	ft_jit_build(const char *src, const char *base, const char *so)
+{
+	char	path[JIT_PATH];
+	char	tmp[JIT_PATH];
+	int		fd;
+	int		err;
+
+	if (snprintf(path, sizeof(path), "%s.%d.c", base, (int)getpid())
+		>= (int)sizeof(path)
+		|| snprintf(tmp, sizeof(tmp), "%s.%d.so", base, (int)getpid())
+		>= (int)sizeof(tmp))
+		return (1);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return (1);
+	err = (write(fd, src, ft_strlen(src)) != (ssize_t)ft_strlen(src));
+	close(fd);
+	err = (err || ft_jit_cc(path, tmp) != 0);
+	unlink(path);
+	if (err || rename(tmp, so) != 0)
+	{
+		unlink(tmp);
+		return (1);
+	}
+	return (0);
+}
+
+/* Loads the native kernel of the current formula, compiling it on a cache
+ miss. Returns 0 on success; on failure the VM keeps running the formula. */
+int	ft_jit_load(t_fractol *f)
+{
+	char	dir[JIT_PATH];
+	char	base[JIT_PATH];
+	char	so[JIT_PATH];
+	char	*src;
+	int		cached;
+
+	src = ft_jit_source(&f->formula);
+	if (!src || ft_cache_dir(dir, sizeof(dir)) != 0
+		|| snprintf(base, sizeof(base), "%s/%016lx", dir, ft_jit_hash(src))
+		>= (int)sizeof(base)
+		|| snprintf(so, sizeof(so), "%s.so", base) >= (int)sizeof(so))
+	{
+		free(src);
+		return (1);
+	}
+	cached = (access(so, R_OK) == 0);
+	if (!cached && ft_jit_build(src, base, so) != 0)
+	{
+		free(src);
+		return (1);
+	}
+	free(src);
+	f->jit.handle = dlopen(so, RTLD_NOW | RTLD_LOCAL);
+	if (f->jit.handle)
+		f->jit.kernel = (t_kernel)dlsym(f->jit.handle, "jit_kernel");
+	if (!f->jit.kernel)
+		ft_jit_unload(f);
+	return (f->jit.kernel == NULL);
+}
+
+void	ft_jit_unload(t_fractol *f)
+{
+	if (f->jit.handle)
+		dlclose(f->jit.handle);
+	f->jit.handle = NULL;
+	f->jit.kernel = NULL;
+}
+
+/* J on the formula type: native kernel on, or back to the VM. */
+void	toggle_jit(t_fractol *f)
+{
+	if (f->fractal.type != 9)
+		return ;
+	if (f->jit.kernel)
+		ft_jit_unload(f);
+	else if (ft_jit_load(f) != 0)
+		ft_putstr_fd("JIT unavailable, the formula stays on the VM\n", 2);
+}
@@ -1,16 +1,42 @@
 #include <signal.h>
 #include "../includes/fractol.h"
 
+/* Center of a deep view from the command line, every digit kept, and the
+ zoom as a power of ten. A center that does not parse leaves the default
+ view. */
+static void	ft_center_args(t_fractol *f, char **av)
+{
+	if (ft_big_from_str(&f->fractal.center[0], av[3], BIG_LIMBS) != 0
+		|| ft_big_from_str(&f->fractal.center[1], av[4], BIG_LIMBS) != 0)
+	{
+		ft_putstr_fd("Error: invalid center, using the default view\n", 2);
+		ft_view_reset(f);
+		return ;
+	}
+	if (av[5])
+		f->fractal.scale = powl(10, ft_atof(av[5]));
+	if (!(f->fractal.scale >= 1))
+		f->fractal.scale = 1;
+	if (f->fractal.scale > ft_scale_limit(f))
+		f->fractal.scale = ft_scale_limit(f);
+	ft_view_move(f, 0, 0);
+}
+
 /*
  * Inizializza i valori della struttura t_fractol per preparare il disegno del frattale.
  *
  * - Imposta il bordo sinistro del piano complesso (xr) a -2.0 per default.
  * - Imposta il bordo superiore del piano complesso (yi) a -1.30 per default.
  * - Se il tipo di frattale è Mandelbrot (type == 2), imposta xr a -2.5 e yi a -1.30.
+ * - Burning Ship (type == 6) parte da xr -2.3 e yi -1.80, con la nave al centro.
+ * - La potenza n vale 2, tranne il Multibrot (type == 5) che parte da z^3 + c.
  * - Imposta il numero di iterazioni di default a 50.
  * - Se viene passato un terzo argomento da linea di comando, lo usa per impostare il numero di iterazioni.
  * - Imposta le costanti cr e ci (usate solo per Julia) a 0 di default.
- * - Se vengono passati quarto e quinto argomento da linea di comando, li usa per impostare cr e ci.
+ * - Per i tipi con zoom profondo (il Mandelbrot) quarto e quinto
+ *   argomento sono il centro della vista, letto in virgola fissa con tutte
+ *   le cifre date (ft_big_from_str), e il sesto lo zoom come potenza di 10.
+ * - Altrimenti, se vengono passati quarto e quinto argomento da linea di comando, li usa per impostare cr e ci.
  *   Lì usa atof (ASCII to float) per convertire i numeri in virgola mobile.
  *   Esempi di cosa fa atof:
  *   atof("3.14") → restituisce 3.14
@@ -19,7 +45,6 @@
  *   atof("42") → restituisce 42.0
  * - Imposta lo zoom (scale) iniziale a 300.00.
  * - Imposta il colore iniziale (r, g, b) rispettivamente a 0x42, 0x32, 0x22.
- * - Imposta le coordinate height e width a 0 per iniziare il disegno dall'angolo in alto a sinistra.
  */
 void	ft_fractol_init(t_fractol *fractol, char **av)
 {
@@ -30,22 +55,33 @@ void	ft_fractol_init(t_fractol *fractol, char **av)
 		fractol->fractal.offset_x = -2.5;
 		fractol->fractal.offset_y = -1.30;
 	}
+	if (fractol->fractal.type == 6)
+	{
+		fractol->fractal.offset_x = -2.3;
+		fractol->fractal.offset_y = -1.80;
+	}
+	fractol->fractal.power = 2;
+	if (fractol->fractal.type == 5)
+		fractol->fractal.power = 3;
 	fractol->fractal.iteration = 50;
+	fractol->fractal.bailout = 4;
 	if (av[2])
 		fractol->fractal.iteration = ft_atoi(av[2]);
 	fractol->fractal.cr = 0;
 	fractol->fractal.ci = 0;
-	if (av[3] && av[4])
+	fractol->fractal.scale = 300.00;
+	ft_view_reset(fractol);
+	if (av[3] && av[4] && ft_scale_limit(fractol) > SCALE_LIMIT)
+		ft_center_args(fractol, av);
+	else if (av[3] && av[4] && fractol->fractal.type != 9)
 	{
 		fractol->fractal.cr = ft_atof(av[3]);
 		fractol->fractal.ci = ft_atof(av[4]);
+		fractol->fractal.custom_c = 1;
 	}
-	fractol->fractal.scale = 300.00;
 	fractol->color.r = 0x42;
 	fractol->color.g = 0x32;
 	fractol->color.b = 0x22;
-	fractol->fractal.pixel_y = 0;
-	fractol->fractal.pixel_x = 0;
 	fractol->last_zoom_time = 0;
 }
 
@@ -57,14 +93,43 @@ void	menu(void)
 	printf("    Mandelbrot...........2\n");
 	printf("    Rabbit...............3\n");
 	printf("    Monster..............4\n");
+	printf("    Multibrot z^n + c....5\n");
+	printf("    Burning Ship.........6\n");
+	printf("    Tricorn..............7\n");
+	printf("    Celtic...............8\n");
+	printf("    Formula..............9\n");
 	printf("(Optional) :\n");
 	printf("Arg 2 : Iteration from 20 to 1000\n");
 	printf("(For Julia Only) :\n");
 	printf("Arg 3 : Real complex number\n");
-	printf("Arg 4 : Imaginary complex number\n\n");
+	printf("Arg 4 : Imaginary complex number\n");
+	printf("(For Mandelbrot) :\n");
+	printf("Arg 3 : Real part of the center, any number of digits\n");
+	printf("Arg 4 : Imaginary part of the center\n");
+	printf("Arg 5 : Zoom as a power of ten, e.g. 30 for 1e30\n");
+	printf("(For Formula Only) :\n");
+	printf("Arg 3 : Iteration formula, e.g. \"z*z*z + c*sin(z)\"\n");
+	printf("        z starts at c; use z, c, i, numbers, + - * / ^n\n");
+	printf("        and sin cos exp log conj abs sqr\n\n");
+	printf("Tile server : ./fractol serve <socket path>\n");
+	printf("    One request per line on the Unix socket:\n");
+	printf("    type iteration z/x/y raw|png [cr ci | formula]\n");
+	printf("    Answer: \"OK z/x/y <bytes>\" and the tile, or \"ERR ...\"\n\n");
 	printf("Commands :\n");
 	printf("    ESC..................Quit\n");
 	printf("    Space................Change Color\n");
+	printf("    C....................Toggle smooth coloring\n");
+	printf("    H....................Toggle histogram coloring\n");
+	printf("    X....................Toggle edge anti-aliasing\n");
+	printf("    F....................Toggle fullscreen\n");
+	printf("    P....................Toggle Julia preview (Mandelbrot)\n");
+	printf("    N....................Next power n, 2 to 8 (Multibrot)\n");
+	printf("    J....................Toggle native JIT kernel (Formula)\n");
+	printf("    E....................Toggle distance estimation\n");
+	printf("    B....................Toggle Buddhabrot (Mandelbrot)\n");
+	printf("    T....................Orbit trap: point, line, cross, circle, off\n");
+	printf("    G....................Zoom to the nearest minibrot (Mandelbrot)\n");
+	printf("    Left click...........Open the previewed Julia\n");
 	printf("    Scroll up............Zoom in\n");
 	printf("    Scroll down..........Zoom out\n\n");
 }
@@ -79,14 +144,8 @@ void	menu(void)
  */
 int	fractal_choice(t_fractol *fractol, char **av)
 {
-	if (av[1][0] == '1' && av[1][1] == '\0')
-		fractol->fractal.type = 1;
-	else if (av[1][0] == '2' && av[1][1] == '\0')
-		fractol->fractal.type = 2;
-	else if (av[1][0] == '3' && av[1][1] == '\0')
-		fractol->fractal.type = 3;
-	else if (av[1][0] == '4' && av[1][1] == '\0')
-		fractol->fractal.type = 4;
+	if (av[1][0] >= '1' && av[1][0] <= '9' && av[1][1] == '\0')
+		fractol->fractal.type = av[1][0] - '0';
 	else
 	{
 		ft_putstr_fd("\n\033[31mError: '", 2);
@@ -95,7 +154,15 @@ int	fractal_choice(t_fractol *fractol, char **av)
 		menu();
 		return (1);
 	}
-	return (0);
+	if (fractol->fractal.type != 9)
+		return (0);
+	if (!av[2] || !av[3])
+	{
+		ft_putstr_fd("\n\033[31mError: missing formula\e[0m\n\n", 2);
+		menu();
+		return (1);
+	}
+	return (ft_formula_compile(&fractol->formula, av[3]));
 }
 
 /*
@@ -158,7 +225,8 @@ In che ordine sono i byte (endian)
  * - Controlla che sia stato passato almeno un argomento da linea di comando.
  * - Sceglie il tipo di frattale in base all'argomento (Julia, Mandelbrot, ecc.) tramite fractal_choice.
  * - Inizializza la connessione con la libreria grafica MiniLibX (mlx_init).
- * - Crea una nuova finestra grafica di dimensioni WIDTH x HEIGHT (mlx_new_window).
+ * - Crea una nuova finestra grafica di dimensioni DEFAULT_WIDTH x DEFAULT_HEIGHT
+ *   (mlx_new_window), ridimensionabile (mlx_window_resizable).
  * - Crea una nuova immagine (buffer) dove verrà disegnato il frattale (mlx_new_image).
  * - Ottiene il puntatore all'area di memoria dell'immagine e informazioni tecniche (mlx_get_data_addr).
  *   Le informazioni tecniche sono:
@@ -196,27 +264,17 @@ static int init_mlx(t_fractol *f)
 		return (1);
 	}
 
-	f->mlx.win = mlx_new_window(f->mlx.mlx, WIDTH, HEIGHT, "Fractol");
+	f->mlx.win = mlx_new_window(f->mlx.mlx, DEFAULT_WIDTH, DEFAULT_HEIGHT,
+			"Fractol");
 	if (!f->mlx.win)
 	{
 		ft_putstr_fd("Error: Failed to create window\n", 2);
 		return (1);
 	}
+	mlx_window_resizable(f->mlx.mlx, f->mlx.win, MIN_WIDTH, MIN_HEIGHT);
 
-	f->mlx.img = mlx_new_image(f->mlx.mlx, WIDTH, HEIGHT);
-	if (!f->mlx.img)
-	{
-		ft_putstr_fd("Error: Failed to create image\n", 2);
-		return (1);
-	}
-	
-	f->mlx.addr = mlx_get_data_addr(f->mlx.img, &f->mlx.bits_per_pixel,
-			&f->mlx.line_length, &f->mlx.endian);
-	if (!f->mlx.addr)
-	{
-		ft_putstr_fd("Error: Failed to get image data address\n", 2);
+	if (ft_image_alloc(f, DEFAULT_WIDTH, DEFAULT_HEIGHT) != 0)
 		return (1);
-	}
 
 	return (0);
 }
@@ -259,6 +317,9 @@ int	main(int argc, char **argv)
 		return (1);
 	}
 
+	if (ft_strncmp(argv[1], "serve", 6) == 0)
+		return (ft_serve(argv[2]));
+
 	ft_bzero(&f, sizeof(t_fractol));
 
 	if (fractal_choice(&f, argv) != 0)
@@ -268,11 +329,21 @@ int	main(int argc, char **argv)
 		clean_exit(&f, 1);
 
 	ft_fractol_init(&f, argv);
+	if (ft_pool_init(&f.pool) != 0)
+	{
+		ft_putstr_fd("Error: Failed to start the render threads\n", 2);
+		clean_exit(&f, 1);
+	}
 	ft_draw(&f);
 
 	mlx_key_hook(f.mlx.win, key, &f);
 	mlx_mouse_hook(f.mlx.win, mouse, &f);
 	mlx_hook(f.mlx.win, 17, 0, close_window, &f);
+	mlx_hook(f.mlx.win, CONFIGURE_NOTIFY, STRUCTURE_NOTIFY_MASK,
+		resize_window, &f);
+	mlx_hook(f.mlx.win, MOTION_NOTIFY, POINTER_MOTION_MASK,
+		preview_motion, &f);
+	mlx_frame_hook(f.mlx.mlx, ft_render_frame, &f, FRAME_MS);
 
 	mlx_loop(f.mlx.mlx);
 	clean_exit(&f, 0);
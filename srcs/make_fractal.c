@@ -1,113 +1,206 @@
 #include "../includes/fractol.h"
-#include <math.h>
-#include <stdint.h>
 
-/* Increase the colors in the struct each time it's called. */
-void	random_colors(t_fractol *fractol)
+/* HUD line of the minibrot locator: searching, gliding or the last miss. */
+static void	ft_string_nucleus(t_fractol *f)
 {
-	fractol->color.r += 15;
-	fractol->color.g += 41;
-	fractol->color.b += 10;
+	char	line[64];
+	int		state;
+
+	state = __atomic_load_n(&f->nucleus.state, __ATOMIC_ACQUIRE);
+	line[0] = '\0';
+	if (state == NUCLEUS_SEARCH)
+		snprintf(line, sizeof(line), "Nucleus : searching...");
+	if (state == NUCLEUS_IDLE && f->nucleus.missed)
+		snprintf(line, sizeof(line), "Nucleus : none within %d iterations",
+			f->nucleus.limit);
+	if (state == NUCLEUS_GLIDE)
+		snprintf(line, sizeof(line), "Nucleus : period %d, zoom to %.3Lg",
+			f->nucleus.period, f->nucleus.target);
+	if (line[0])
+		mlx_string_put(f->mlx.mlx, f->mlx.win, 10, 125, 0xFFFFFF, line);
 }
 
-/* Write a pixel using bits_per_pixel and line_length (safe for MLX) */
-static void	put_pixel_raw(t_fractol *f, int x, int y, int r, int g, int b)
+/* Function that writes information to the hud */
+void	ft_string(t_fractol *f)
 {
-	char	*dst;
-	int		bytes_per_pixel;
-	int		line;
+	char	line[64];
+	char	*num;
+	char	*str;
 
-	if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
-		return ;
-	bytes_per_pixel = f->mlx.bits_per_pixel / 8;
-	line = f->mlx.line_length;
-	dst = f->mlx.addr + (y * line + x * bytes_per_pixel);
-	if (bytes_per_pixel >= 3)
+	num = ft_itoa(f->fractal.iteration);
+	str = ft_strjoin("Number of iterations : ", num);
+	mlx_string_put(f->mlx.mlx, f->mlx.win, 10, 5, 0xFFFFFF, str);
+	free(num);
+	free(str);
+	snprintf(line, sizeof(line), "Scale value : %.6Lg", f->fractal.scale);
+	mlx_string_put(f->mlx.mlx, f->mlx.win, 10, 35, 0xFFFFFF, line);
+	if (f->frame.orbit)
 	{
-		dst[0] = (char)r;
-		dst[1] = (char)g;
-		dst[2] = (char)b;
+		snprintf(line, sizeof(line), "Series skipped iterations : %d / %d",
+			f->frame.orbit->skip, f->frame.iteration);
+		mlx_string_put(f->mlx.mlx, f->mlx.win, 10, 95, 0xFFFFFF, line);
 	}
-	if (bytes_per_pixel == 4)
-		dst[3] = 0;
+	ft_string_nucleus(f);
+	if (!f->render.antialias)
+		return ;
+	num = ft_itoa(f->render.aa_count);
+	str = ft_strjoin("AA refined pixels : ", num);
+	mlx_string_put(f->mlx.mlx, f->mlx.win, 10, 65, 0xFFFFFF, str);
+	free(num);
+	free(str);
 }
 
-/* Function that places the color pixel in the image according to depth. */
-void	put_pixel(t_fractol *fractol, int depth)
+/* Colors pixels x0 .. x1 - 1 of row y from the escape values of the
+ frame. */
+void	ft_paint_span(t_fractol *f, int y, int x0, int x1)
 {
-	int	r;
-	int	g;
-	int	b;
-	int	x;
-	int	y;
+	uint32_t	*dst;
+	uint32_t	*lut;
+	float		*values;
+	float		*dist;
+	int			steps;
+	int			x;
 
-	x = (int)fractol->fractal.pixel_x;
-	y = (int)fractol->fractal.pixel_y;
-	if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
-		return ;
-	if (depth == fractol->fractal.iteration)
+	values = f->render.values + y * f->mlx.width;
+	dist = f->render.dist + y * f->mlx.width;
+	x = x0 - 1;
+	if (f->mlx.bits_per_pixel != 32)
 	{
-		r = 0;
-		g = 0;
-		b = 0;
+		while (++x < x1)
+			put_pixel(f, x, y, values[x]);
+		return ;
 	}
-	else
+	dst = (uint32_t *)(f->mlx.addr + y * f->mlx.line_length);
+	lut = f->palette.lut;
+	steps = f->palette.steps;
+	while (++x < x1)
 	{
-		r = ((int)(fractol->color.r + (depth * 2.42))) & 0xFF;
-		g = ((int)(fractol->color.g + (depth * 3.52))) & 0xFF;
-		b = ((int)(fractol->color.b + (depth * 4.65))) & 0xFF;
+		if (values[x] < f->frame.iteration)
+			dst[x] = lut[(int)(values[x] * steps)];
+		else
+			dst[x] = 0;
+		if (f->frame.de)
+			dst[x] = ft_de_shade(f, dst[x], dist[x]);
 	}
-	put_pixel_raw(fractol, x, y, r, g, b);
 }
 
-/* Function that writes information to the hud */
-void	ft_string(t_fractol *f)
+/* Pool job: computes one row with the kernel resolved for the frame, the
+ tiles found in the cache apart, keeps its escape values for the later passes
+ and colors it. */
+static void	ft_draw_row(void *arg, int index, int thread)
 {
-	char	*num;
-	char	*str;
+	t_fractol	*f;
+	t_row		row;
+	int			y;
 
-	num = ft_itoa(f->fractal.iteration);
-	str = ft_strjoin("Number of iterations : ", num);
-	mlx_string_put(f->mlx.mlx, f->mlx.win, 10, 5, 0xFFFFFF, str);
-	free(num);
-	free(str);
-	num = ft_itoa((int)f->fractal.scale);
-	str = ft_strjoin("Scale value : ", num);
-	mlx_string_put(f->mlx.mlx, f->mlx.win, 10, 35, 0xFFFFFF, str);
-	free(num);
-	free(str);
+	(void)thread;
+	f = arg;
+	y = f->render.row + index;
+	row.count = f->mlx.width;
+	row.out = f->render.values + y * f->mlx.width;
+	row.dist = NULL;
+	if (f->frame.de)
+		row.dist = f->render.dist + y * f->mlx.width;
+	row.glitch = NULL;
+	if (f->frame.orbit)
+		row.glitch = f->render.glitch + y * f->mlx.width;
+	ft_tiles_row(f, y, &row);
+	ft_paint_span(f, y, 0, f->mlx.width);
 }
 
-/* Function that starts the calculation of the depth of the good fractal,
- sends it to the put_pixel and puts everything in the image. */
+/* Function that starts a new frame from the first row. The rows are
+ computed by ft_render_frame, a few at a time, from the frame hook. */
 int	ft_draw(t_fractol *f)
 {
-	int depth;
-	int x;
-	int y;
+	f->render.row = 0;
+	f->render.aa_row = 0;
+	f->render.aa_count = 0;
+	f->histo.ready = 0;
+	f->buddha.reset = 1;
+	f->refs.pending = 1;
+	f->refs.round = 0;
+	return (0);
+}
+
+/* Whole frame at once, without a window (server.c): rows, glitch
+ correction, tile cache and histogram, no anti-aliasing. */
+void	ft_render_image(t_fractol *f)
+{
+	ft_draw(f);
+	ft_palette_update(f);
+	ft_frame_setup(f);
+	ft_tiles_begin(f);
+	ft_pool_run(&f->pool, ft_draw_row, f, f->mlx.height);
+	f->render.row = f->mlx.height;
+	while (ft_glitch_pending(f))
+		ft_glitch_round(f);
+	ft_tiles_store(f);
+	if (f->histo.enabled)
+		ft_histogram_pass(f);
+}
 
-	y = 0;
-	while (y < HEIGHT)
+static int	ft_frame_pending(t_fractol *f)
+{
+	return (f->render.row < f->mlx.height || ft_glitch_pending(f)
+		|| (f->render.antialias && f->render.aa_row < f->mlx.height));
+}
+
+/* Frame hook: renders chunks of rows on the pool until the deadline, then
+ the glitch correction of a perturbed frame and the histogram and
+ anti-aliasing passes if enabled, shows the partial image and returns 1
+ while work is left, 0 (idle) once the frame is complete. A finished frame
+ only redraws the Julia preview inset when the mouse moved, or waits on the
+ minibrot locator while it searches or zooms. */
+int	ft_render_frame(long deadline, t_fractol *f)
+{
+	int	rows;
+	int	clean;
+
+	if (ft_buddha_active(f))
+		return (ft_buddha_frame(deadline, f));
+	if (!ft_frame_pending(f))
 	{
-		x = 0;
-		while (x < WIDTH)
-		{
-			f->fractal.pixel_x = (double)x;
-			f->fractal.pixel_y = (double)y;
-			if (f->fractal.type == 1)
-				depth = julia(f);
-			else if (f->fractal.type == 2)
-				depth = mandelbrot(f);
-			else if (f->fractal.type == 3)
-				depth = rabbit(f);
-			else
-				depth = monster(f);
-			put_pixel(f, depth);
-			x++;
-		}
-		y++;
+		if (ft_nucleus_frame(f))
+			return (1);
+		if (!f->preview.dirty || !ft_preview_active(f))
+			return (0);
+		ft_preview_draw(f);
+		mlx_put_image_to_window(f->mlx.mlx, f->mlx.win, f->mlx.img, 0, 0);
+		ft_string(f);
+		return (0);
 	}
+	if (f->render.row == 0)
+	{
+		ft_palette_update(f);
+		ft_frame_setup(f);
+		ft_tiles_begin(f);
+	}
+	while (f->render.row < f->mlx.height)
+	{
+		rows = RENDER_CHUNK * ft_pool_size(&f->pool);
+		if (rows > f->mlx.height - f->render.row)
+			rows = f->mlx.height - f->render.row;
+		ft_pool_run(&f->pool, ft_draw_row, f, rows);
+		f->render.row += rows;
+		if (ft_time_us() >= deadline)
+			break ;
+	}
+	while (f->render.row >= f->mlx.height && ft_glitch_pending(f)
+		&& ft_time_us() < deadline)
+		ft_glitch_round(f);
+	clean = (f->render.row >= f->mlx.height && !ft_glitch_pending(f));
+	if (clean)
+		ft_tiles_store(f);
+	if (clean && f->histo.enabled && !f->histo.ready)
+		ft_histogram_pass(f);
+	if (clean && f->render.antialias && ft_time_us() < deadline)
+		ft_antialias_slice(f, deadline);
+	if (!ft_frame_pending(f) && ft_preview_active(f))
+		ft_preview_draw(f);
 	mlx_put_image_to_window(f->mlx.mlx, f->mlx.win, f->mlx.img, 0, 0);
+	if (ft_frame_pending(f))
+		return (1);
 	ft_string(f);
-	return (0);
+	return (__atomic_load_n(&f->nucleus.state, __ATOMIC_ACQUIRE)
+		!= NUCLEUS_IDLE);
 }
@@ -0,0 +1,424 @@
+#include "../includes/fractol.h"
+#include "../includes/floatexp.h"
+
+/*
+ * LOCALIZZATORE DI MINIBROT - Con G si cerca il nucleo (il centro) del
+ * minibrot piu' vicino al centro della vista e ci si zooma sopra da soli,
+ * invece di arrivarci con centinaia di rotellate.
+ *
+ * PERIODO (box period): si seguono i quattro angoli della vista mentre
+ * il centro C itera z_{n+1} = z_n² + C; gli angoli per perturbazione,
+ *   d_{n+1} = d_n (2 z_n + d_n) + dc    (in floatexp)
+ * Il primo n per cui il quadrilatero degli angoli z_n + d_n gira attorno
+ * allo 0 e' il periodo p del minibrot piu' basso nella vista: un c della
+ * vista ha z_p = 0, cioe' e' un nucleo. La prova e' quella del raggio:
+ * un numero dispari di lati taglia il semiasse reale positivo. Se un
+ * angolo fugge prima la scatola si dimezza attorno a C, fino a
+ * NUCLEUS_SHRINK volte: la vista ha punti fuori dall'insieme.
+ *
+ * NUCLEO (Newton): si risolve z_p(c) = 0 partendo da C,
+ *   c -> c - z_p / z_p'    con z'_{n+1} = 2 z_n z'_n + 1
+ * z in virgola fissa (bignum.c) con i bit dello zoom, z' in floatexp: a
+ * zoom profondi cresce oltre il double, e come divisore gli bastano 53
+ * bit. La stessa orbita da' la dimensione del minibrot:
+ *   l = prodotto di 2 z_j, b = somma di 1 / l (j = 1 .. p - 1)
+ *   size = 1 / |b l²|
+ * Newton si ferma quando il passo e' sotto size 2^-NUCLEUS_DIGITS; se il
+ * minibrot chiede piu' bit di quelli dello zoom di partenza la precisione
+ * sale (ft_big_limbs) e Newton continua da dove era.
+ *
+ * THREAD: la ricerca costa migliaia di iterazioni in virgola fissa per
+ * passo, quindi gira su un thread suo, su una copia della vista, mentre il
+ * rendering continua. Lo stato (NUCLEUS_*) e' l'unico campo condiviso: il
+ * thread lo porta a NUCLEUS_DONE, il frame hook lo legge, raccoglie il
+ * thread, centra la vista sul nucleo e la fa avanzare di uno zoom per
+ * frame completo (NUCLEUS_GLIDE) fino a mostrare il minibrot largo
+ * 1/NUCLEUS_FILL della finestra. Zoom, spostamenti o un altro G annullano
+ * la ricerca o la planata.
+ */
+
+/* r = a b, complex. */
+static void	ft_cx_mul(t_fexp *r, const t_fexp *a, const t_fexp *b)
+{
+	t_fexp	re;
+
+	re = fe_sub(fe_mul(a[0], b[0]), fe_mul(a[1], b[1]));
+	r[1] = fe_add(fe_mul(a[0], b[1]), fe_mul(a[1], b[0]));
+	r[0] = re;
+}
+
+/* |a|². */
+static t_fexp	ft_cx_norm(const t_fexp *a)
+{
+	return (fe_add(fe_mul(a[0], a[0]), fe_mul(a[1], a[1])));
+}
+
+/* 1 / x and sqrt(x), x > 0 normalized. */
+static t_fexp	ft_fe_inv(t_fexp x)
+{
+	return (fe_norm(1 / x.m, -x.e));
+}
+
+static t_fexp	ft_fe_sqrt(t_fexp x)
+{
+	if (x.m == 0)
+		return (x);
+	if (x.e & 1)
+		return (fe_norm(sqrt(2 * x.m), (x.e - 1) / 2));
+	return (fe_norm(sqrt(x.m), x.e / 2));
+}
+
+/* z = z² + c, in fixed point; t is scratch. */
+static void	ft_nucleus_step(t_big *z, const t_big *c, t_big *t)
+{
+	ft_big_add(&t[0], &z[0], &z[1]);
+	ft_big_sub(&t[1], &z[0], &z[1]);
+	ft_big_mul(&t[2], &z[0], &z[1]);
+	ft_big_mul(&z[0], &t[0], &t[1]);
+	ft_big_add(&z[0], &z[0], &c[0]);
+	ft_big_add(&z[1], &t[2], &t[2]);
+	ft_big_add(&z[1], &z[1], &c[1]);
+}
+
+static int	ft_nucleus_quit(t_nucleus *n)
+{
+	return (__atomic_load_n(&n->quit, __ATOMIC_ACQUIRE));
+}
+
+/* The polygon w winds around 0: odd number of edges crossing the positive
+ real axis, x = (a.re b.im - a.im b.re) / (b.im - a.im) > 0. */
+static int	ft_nucleus_winds(t_fexp (*w)[2])
+{
+	t_fexp	cross;
+	int		inside;
+	int		k;
+	int		j;
+
+	inside = 0;
+	k = -1;
+	while (++k < 4)
+	{
+		j = (k + 1) % 4;
+		if ((w[k][1].m < 0) == (w[j][1].m < 0))
+			continue ;
+		cross = fe_sub(fe_mul(w[k][0], w[j][1]), fe_mul(w[k][1], w[j][0]));
+		if ((cross.m > 0) == (w[j][1].m >= 0))
+			inside = !inside;
+	}
+	return (inside);
+}
+
+/* Lowest period of the view box: the first n at which the image of its
+ four corners winds around 0. The corners follow the center by
+ perturbation, d -> d (2 z + d) + dc. -1 if a corner escapes first, 0 if
+ the limit comes first. */
+static int	ft_nucleus_period(t_nucleus *n, const t_big *c)
+{
+	static const double	dir[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+	t_big				z[2];
+	t_big				t[3];
+	t_fexp				d[4][2];
+	t_fexp				w[4][2];
+	t_fexp				zf[2];
+	int					p;
+	int					k;
+
+	k = -1;
+	while (++k < 8)
+		d[k / 2][k % 2] = fe_mul_d(n->box[k % 2], dir[k / 2][k % 2]);
+	z[0] = c[0];
+	z[1] = c[1];
+	p = 0;
+	while (++p <= n->limit && !ft_nucleus_quit(n))
+	{
+		zf[0] = ft_big_to_fexp(&z[0]);
+		zf[1] = ft_big_to_fexp(&z[1]);
+		k = -1;
+		while (++k < 4)
+		{
+			w[k][0] = fe_add(zf[0], d[k][0]);
+			w[k][1] = fe_add(zf[1], d[k][1]);
+			if (fe_to_d(ft_cx_norm(w[k])) > 16)
+				return (-1);
+		}
+		if (ft_nucleus_winds(w))
+			return (p);
+		zf[0] = fe_mul_d(zf[0], 2);
+		zf[1] = fe_mul_d(zf[1], 2);
+		k = -1;
+		while (++k < 4)
+		{
+			w[k][0] = fe_add(zf[0], d[k][0]);
+			w[k][1] = fe_add(zf[1], d[k][1]);
+			ft_cx_mul(d[k], d[k], w[k]);
+			d[k][0] = fe_add(d[k][0], fe_mul_d(n->box[0], dir[k][0]));
+			d[k][1] = fe_add(d[k][1], fe_mul_d(n->box[1], dir[k][1]));
+		}
+		ft_nucleus_step(z, c, t);
+	}
+	return (0);
+}
+
+/* One Newton step on c for period p, and the size of the minibrot from
+ l (v[1]) and b (v[2]). Returns 1 if the orbit escapes: no nucleus from
+ here. */
+static int	ft_nucleus_newton(t_nucleus *n, t_big *c, t_fexp *step,
+		t_fexp *size)
+{
+	t_big	z[2];
+	t_big	t[3];
+	t_fexp	v[4][2];
+	int		k;
+
+	ft_big_zero(&z[0], c[0].len);
+	ft_big_zero(&z[1], c[0].len);
+	v[0][0] = fe_from(0);
+	v[0][1] = fe_from(0);
+	v[1][0] = fe_from(1);
+	v[1][1] = fe_from(0);
+	v[2][0] = fe_from(1);
+	v[2][1] = fe_from(0);
+	k = 0;
+	while (++k <= n->period)
+	{
+		v[3][0] = fe_mul_d(ft_big_to_fexp(&z[0]), 2);
+		v[3][1] = fe_mul_d(ft_big_to_fexp(&z[1]), 2);
+		ft_cx_mul(v[0], v[0], v[3]);
+		v[0][0] = fe_add(v[0][0], fe_from(1));
+		ft_nucleus_step(z, c, t);
+		if (fabsl(ft_big_to_ld(&z[0])) + fabsl(ft_big_to_ld(&z[1])) > 8)
+			return (1);
+		if (k == n->period)
+			break ;
+		v[3][0] = fe_mul_d(ft_big_to_fexp(&z[0]), 2);
+		v[3][1] = fe_mul_d(ft_big_to_fexp(&z[1]), 2);
+		ft_cx_mul(v[1], v[1], v[3]);
+		v[3][0] = ft_fe_inv(ft_cx_norm(v[1]));
+		v[2][0] = fe_add(v[2][0], fe_mul(v[1][0], v[3][0]));
+		v[2][1] = fe_sub(v[2][1], fe_mul(v[1][1], v[3][0]));
+	}
+	v[3][0] = ft_big_to_fexp(&z[0]);
+	v[3][1] = ft_big_to_fexp(&z[1]);
+	v[0][1] = fe_mul_d(v[0][1], -1);
+	ft_cx_mul(step, v[3], v[0]);
+	v[3][0] = ft_fe_inv(ft_cx_norm(v[0]));
+	step[0] = fe_mul(step[0], v[3][0]);
+	step[1] = fe_mul(step[1], v[3][0]);
+	*size = ft_fe_inv(fe_mul(ft_fe_sqrt(ft_cx_norm(v[2])),
+				ft_cx_norm(v[1])));
+	return (0);
+}
+
+/* c -= step, at the precision of c. */
+static void	ft_nucleus_move(t_big *c, const t_fexp *step)
+{
+	t_big	d;
+
+	ft_big_from_fexp(&d, step[0], c[0].len);
+	ft_big_sub(&c[0], &c[0], &d);
+	ft_big_from_fexp(&d, step[1], c[1].len);
+	ft_big_sub(&c[1], &c[1], &d);
+}
+
+/* Newton from the view center until the step is below the minibrot by
+ NUCLEUS_DIGITS bits; 1 if it does not converge. */
+static int	ft_nucleus_solve(t_nucleus *n, t_big *c)
+{
+	t_fexp	step[2];
+	t_fexp	size;
+	t_big	t;
+	int		limbs;
+	int		i;
+
+	i = 0;
+	while (++i <= NUCLEUS_NEWTON && !ft_nucleus_quit(n))
+	{
+		if (ft_nucleus_newton(n, c, step, &size) != 0)
+			return (1);
+		ft_nucleus_move(c, step);
+		n->size = ldexpl(size.m, size.e);
+		limbs = ft_big_limbs(fmaxl(n->scale, 1 / n->size));
+		if (limbs > c[0].len)
+		{
+			ft_big_resize(&t, &c[0], limbs);
+			c[0] = t;
+			ft_big_resize(&t, &c[1], limbs);
+			c[1] = t;
+		}
+		else if (fe_less(ft_cx_norm(step), fe_mul(size, fe_norm(size.m,
+						size.e - 2 * NUCLEUS_DIGITS))))
+			return (0);
+	}
+	return (1);
+}
+
+/* far = c - n->c, and c kept in n->c at BIG_LIMBS. */
+static void	ft_nucleus_keep(t_nucleus *n, const t_big *c, t_fexp *far)
+{
+	t_big	d;
+	int		k;
+
+	k = -1;
+	while (++k < 2)
+	{
+		ft_big_resize(&d, &c[k], BIG_LIMBS);
+		ft_big_sub(&n->c[k], &d, &n->c[k]);
+		far[k] = ft_big_to_fexp(&n->c[k]);
+		n->c[k] = d;
+	}
+}
+
+/* Search thread: period, then nucleus. Where the view holds escaping
+ points the box shrinks around the center until its corners stay bounded.
+ The nucleus must lie near the box, or Newton wandered off to another
+ atom; a size above the main cardioid's (1) is a nucleus of a lower
+ period, where some z_k is 0 before p. */
+static void	*ft_nucleus_search(void *arg)
+{
+	t_nucleus	*n;
+	t_big		c[2];
+	t_fexp		far[2];
+	int			limbs;
+	int			k;
+
+	n = arg;
+	limbs = ft_big_limbs(n->scale);
+	ft_big_resize(&c[0], &n->c[0], limbs);
+	ft_big_resize(&c[1], &n->c[1], limbs);
+	n->period = ft_nucleus_period(n, c);
+	k = 0;
+	while (n->period < 0 && ++k < NUCLEUS_SHRINK)
+	{
+		n->box[0] = fe_mul_d(n->box[0], 0.5);
+		n->box[1] = fe_mul_d(n->box[1], 0.5);
+		n->period = ft_nucleus_period(n, c);
+	}
+	if (n->period > 0 && ft_nucleus_solve(n, c) == 0)
+	{
+		ft_nucleus_keep(n, c, far);
+		n->found = (n->size <= 1 && fe_less(ft_cx_norm(far),
+					fe_mul_d(ft_cx_norm(n->box), 4)));
+	}
+	__atomic_store_n(&n->state, NUCLEUS_DONE, __ATOMIC_RELEASE);
+	return (NULL);
+}
+
+/* G: searches from the center of the view, or stops the search or the
+ glide under way. Only for the types that zoom deep (the Mandelbrot). */
+void	toggle_nucleus(t_fractol *f)
+{
+	t_nucleus	*n;
+	long double	r;
+	int			e;
+	int			k;
+
+	n = &f->nucleus;
+	if (__atomic_load_n(&n->state, __ATOMIC_ACQUIRE) != NUCLEUS_IDLE)
+	{
+		ft_nucleus_cancel(f);
+		return ;
+	}
+	n->missed = 0;
+	if (ft_scale_limit(f) <= SCALE_LIMIT || ft_buddha_active(f))
+		return ;
+	n->c[0] = f->fractal.center[0];
+	n->c[1] = f->fractal.center[1];
+	k = -1;
+	while (++k < 2)
+	{
+		r = (k ? f->mlx.height : f->mlx.width) / 2.0L / f->fractal.scale;
+		n->box[k].m = frexpl(r, &e);
+		n->box[k].e = e;
+	}
+	n->scale = f->fractal.scale;
+	n->limit = f->fractal.iteration;
+	n->found = 0;
+	n->quit = 0;
+	n->state = NUCLEUS_SEARCH;
+	if (pthread_create(&n->thread, NULL, ft_nucleus_search, n) != 0)
+		n->state = NUCLEUS_IDLE;
+}
+
+/* The view is changing by hand: the glide stops, a running search is
+ dropped when it ends. */
+void	ft_nucleus_cancel(t_fractol *f)
+{
+	int	state;
+
+	state = __atomic_load_n(&f->nucleus.state, __ATOMIC_ACQUIRE);
+	f->nucleus.missed = 0;
+	if (state == NUCLEUS_GLIDE)
+		f->nucleus.state = NUCLEUS_IDLE;
+	else if (state != NUCLEUS_IDLE)
+		__atomic_store_n(&f->nucleus.quit, 1, __ATOMIC_RELEASE);
+}
+
+/* Waits for the search thread, before exiting. */
+void	ft_nucleus_stop(t_fractol *f)
+{
+	int	state;
+
+	state = __atomic_load_n(&f->nucleus.state, __ATOMIC_ACQUIRE);
+	if (state == NUCLEUS_SEARCH || state == NUCLEUS_DONE)
+	{
+		__atomic_store_n(&f->nucleus.quit, 1, __ATOMIC_RELEASE);
+		pthread_join(f->nucleus.thread, NULL);
+	}
+	f->nucleus.state = NUCLEUS_IDLE;
+}
+
+/* Result of the search: the view moves to the nucleus, with enough
+ iterations for its minibrot, and the glide starts. A miss only shows in
+ the HUD of the current image. */
+static void	ft_nucleus_land(t_fractol *f, t_nucleus *n)
+{
+	pthread_join(n->thread, NULL);
+	n->state = NUCLEUS_IDLE;
+	if (n->quit)
+		return ;
+	if (!n->found)
+	{
+		n->missed = 1;
+		mlx_put_image_to_window(f->mlx.mlx, f->mlx.win, f->mlx.img, 0, 0);
+		ft_string(f);
+		return ;
+	}
+	f->fractal.center[0] = n->c[0];
+	f->fractal.center[1] = n->c[1];
+	ft_view_move(f, 0, 0);
+	if (f->fractal.iteration < NUCLEUS_ITER * n->period)
+		f->fractal.iteration = NUCLEUS_ITER * n->period;
+	n->target = fminl(f->mlx.width, f->mlx.height)
+		/ (NUCLEUS_FILL * n->size);
+	if (n->target > ft_scale_limit(f))
+		n->target = ft_scale_limit(f);
+	n->state = NUCLEUS_GLIDE;
+	ft_draw(f);
+}
+
+/* Called by the frame hook once a frame is complete. Returns 1 while the
+ search or the glide needs more frames: the hook must not go idle. */
+int	ft_nucleus_frame(t_fractol *f)
+{
+	t_nucleus	*n;
+	int			state;
+
+	n = &f->nucleus;
+	if (__atomic_load_n(&n->state, __ATOMIC_ACQUIRE) == NUCLEUS_DONE)
+		ft_nucleus_land(f, n);
+	state = __atomic_load_n(&n->state, __ATOMIC_ACQUIRE);
+	if (state == NUCLEUS_SEARCH)
+		return (1);
+	if (state != NUCLEUS_GLIDE)
+		return (0);
+	if (f->fractal.scale * SCALE_PRS > n->target)
+	{
+		n->state = NUCLEUS_IDLE;
+		return (0);
+	}
+	f->fractal.scale *= SCALE_PRS;
+	f->fractal.iteration += SCALE_ITER;
+	ft_view_move(f, 0, 0);
+	ft_draw(f);
+	return (1);
+}
@@ -0,0 +1,758 @@
+#include "../includes/engine.h"
+#include "../includes/floatexp.h"
+#include <sched.h>
+
+/*
+ * PERTURBAZIONE - Oltre DOUBLE_SCALE_LIMIT i pixel distano tra loro meno
+ * di quanto il double riesca a distinguere vicino a c, e il Mandelbrot
+ * diventa a blocchi. Si calcola allora una sola orbita di riferimento Z_n,
+ * nel centro C della vista, in virgola fissa (bignum.c) con tanti bit
+ * quanti ne chiede lo zoom, e per ogni pixel c = C + dc
+ * solo la differenza d_n = z_n - Z_n, che resta piccola e sta bene in
+ * double:
+ *   d_{n+1} = 2 Z_n d_n + d_n² + dc = d_n (2 Z_n + d_n) + dc
+ * Z_n arriva gia' arrotondato a double (t_orbit.re/im): tutte le corsie
+ * usano lo stesso Z_n, quindi il ciclo resta vettoriale come in engine.h.
+ * Se l'orbita di riferimento fugge prima dei pixel si "ribasa": d = z e si
+ * riparte da Z_0 = 0, che e' esatto.
+ *
+ * APPROSSIMAZIONE IN SERIE:
+ * - d_n come polinomio in dc: d_n = A1 dc + A2 dc² + ... + AK dc^K, con
+ *   A_{k,n+1} = 2 Z_n A_{k,n} + somma_{i+j=k} A_{i,n} A_{j,n} (+1 per k=1)
+ * - i coefficienti sono salvati moltiplicati per radius^k (u = dc/radius,
+ *   |u| <= 1 nella vista): cosi' restano dell'ordine di d
+ * - la serie vale finche' e' vicina alla vera perturbazione: la si
+ *   confronta a ogni iterazione con SA_PROBES punti sonda (angoli e centri
+ *   dei lati della vista), e ci si ferma alla prima iterazione in cui una
+ *   sonda sbaglia piu' di SA_TOLERANCE (errore relativo) o fugge
+ * - tutti i pixel partono da quell'iterazione (skip), con d dato dalla
+ *   serie: le prime skip iterazioni non vengono piu' calcolate
+ * Un gruppo di pixel che risulta gia' fuggito a skip (una zona che fugge
+ * presto in mezzo alla vista, che le sonde non vedono) viene ricalcolato
+ * da 0 senza serie.
+ *
+ * OLTRE IL DOUBLE (FEXP_SCALE_LIMIT):
+ * - sotto ~1e-308 dc e d vanno in underflow anche in double: la serie e'
+ *   calcolata sempre in floatexp (floatexp.h) e le coordinate della riga
+ *   arrivano in unita' del raggio (u = dc / radius), che stanno in double
+ * - nei frame oltre il limite d parte in floatexp (perturb_fexp) e passa
+ *   al ciclo in double appena tutte le corsie superano 2^FEXP_SWITCH: d
+ *   cresce a ogni iterazione, quindi la fase lenta e' breve, e il dc che
+ *   nel ciclo in double diventa 0 e' trascurabile rispetto a d
+ * - sotto il limite il kernel non tocca il floatexp
+ *
+ * GLITCH: quando z = Z + d passa molto piu' vicino a 0 di Z, |z|² <
+ * GLITCH_TOLERANCE |Z|² (criterio di Pauldelbrot), d ha perso le cifre che
+ * contano e il pixel non segue piu' la sua orbita. La corsia finisce lo
+ * stesso (il valore resta come ripiego) ma viene segnata in row->glitch:
+ * glitch.c la ricalcola con un riferimento piu' vicino.
+ *
+ * Dopo la serie le iterazioni avanzano con i salti della tabella BLA
+ * (bla.c) quando d di tutte le corsie sta nel raggio del salto, e con il
+ * passo normale altrimenti: le corsie restano sullo stesso indice m.
+ */
+
+#define SA_PROBES	8
+
+/* Real part of the next z: (zr + zi)(zr - zi) + cr, one product. */
+static void	ft_orbit_real(t_bigorbit *b)
+{
+	t_big	*z;
+	t_big	s;
+	t_big	t;
+
+	z = b->z[b->cur];
+	ft_big_add(&s, &z[0], &z[1]);
+	ft_big_sub(&t, &z[0], &z[1]);
+	ft_big_mul(&s, &s, &t);
+	ft_big_add(&b->z[!b->cur][0], &s, &b->c[0]);
+}
+
+/* Imaginary part of the next z: 2 zr zi + ci. */
+static void	ft_orbit_imag(t_bigorbit *b)
+{
+	t_big	*z;
+	t_big	p;
+
+	z = b->z[b->cur];
+	ft_big_mul(&p, &z[0], &z[1]);
+	ft_big_add(&p, &p, &p);
+	ft_big_add(&b->z[!b->cur][1], &p, &b->c[1]);
+}
+
+/* Spins until *flag is value, yielding the CPU after BIG_SPIN tries. */
+static void	ft_orbit_wait(int *flag, int value)
+{
+	int	spin;
+
+	spin = 0;
+	while (__atomic_load_n(flag, __ATOMIC_ACQUIRE) != value)
+		if (++spin > BIG_SPIN)
+			sched_yield();
+}
+
+/* Second thread of a wide reference: the imaginary part of every
+ iteration, while the caller computes the real one. */
+static void	*ft_orbit_partner(void *arg)
+{
+	t_bigorbit	*b;
+
+	b = arg;
+	while (1)
+	{
+		ft_orbit_wait(&b->turn, 1);
+		if (b->quit)
+			break ;
+		ft_orbit_imag(b);
+		__atomic_store_n(&b->turn, 0, __ATOMIC_RELEASE);
+	}
+	return (NULL);
+}
+
+/* Z_n .. Z_length of the reference in fixed point, at o->limbs, stored as
+ double, from n = 0 or from the last one stored when the orbit goes on. The
+ two halves of an iteration are independent products: past BIG_PARALLEL
+ limbs, with a spare CPU, they run on two threads. */
+static void	ft_orbit_iterate(t_orbit *o, const t_frame *fr, t_bigorbit *b,
+		int partner)
+{
+	long double	zr;
+	long double	zi;
+	int			n;
+
+	n = o->length;
+	while (1)
+	{
+		zr = ft_big_to_ld(&b->z[b->cur][0]);
+		zi = ft_big_to_ld(&b->z[b->cur][1]);
+		o->re[n] = zr;
+		o->im[n] = zi;
+		if (n >= fr->iteration || zr * zr + zi * zi >= fr->bailout)
+			break ;
+		if (partner)
+			__atomic_store_n(&b->turn, 1, __ATOMIC_RELEASE);
+		ft_orbit_real(b);
+		if (partner)
+			ft_orbit_wait(&b->turn, 0);
+		else
+			ft_orbit_imag(b);
+		b->cur = !b->cur;
+		n++;
+	}
+	o->length = n;
+}
+
+/* Room for Z_0 .. Z_iteration, keeping the first keep + 1 entries. */
+static int	ft_orbit_grow(t_orbit *o, int iteration, int keep)
+{
+	double	*re;
+	double	*im;
+
+	if (o->cap >= iteration + 1)
+		return (0);
+	re = malloc(sizeof(double) * (iteration + 1));
+	im = malloc(sizeof(double) * (iteration + 1));
+	if (re && im && keep >= 0)
+	{
+		ft_memcpy(re, o->re, sizeof(double) * (keep + 1));
+		ft_memcpy(im, o->im, sizeof(double) * (keep + 1));
+	}
+	free(o->re);
+	free(o->im);
+	o->re = re;
+	o->im = im;
+	o->cap = (iteration + 1) * (re && im);
+	return (o->cap == 0);
+}
+
+/* Reference at c, truncated to o->limbs, or when c is NULL the same
+ reference carried on from Z_length up to the frame's iteration count.
+ spare: a CPU is free for the partner thread. */
+static int	ft_orbit_reference(t_orbit *o, const t_frame *fr, const t_big *c,
+		int spare)
+{
+	t_bigorbit	*b;
+	pthread_t	thread;
+	int			partner;
+	int			keep;
+
+	if (!o->big)
+		o->big = ft_calloc(1, sizeof(t_bigorbit));
+	o->reach = 0;
+	keep = -1;
+	if (!c)
+		keep = o->length;
+	if (!o->big || ft_orbit_grow(o, fr->iteration, keep) != 0)
+		return (1);
+	b = o->big;
+	if (c)
+	{
+		ft_big_resize(&b->c[0], &c[0], o->limbs);
+		ft_big_resize(&b->c[1], &c[1], o->limbs);
+		ft_big_zero(&b->z[0][0], o->limbs);
+		ft_big_zero(&b->z[0][1], o->limbs);
+		b->cur = 0;
+		o->length = 0;
+	}
+	b->turn = 0;
+	b->quit = 0;
+	partner = (o->limbs >= BIG_PARALLEL && spare
+			&& pthread_create(&thread, NULL, ft_orbit_partner, b) == 0);
+	ft_orbit_iterate(o, fr, b, partner);
+	if (partner)
+	{
+		b->quit = 1;
+		__atomic_store_n(&b->turn, 1, __ATOMIC_RELEASE);
+		pthread_join(thread, NULL);
+	}
+	o->reach = fr->iteration;
+	o->bailout = fr->bailout;
+	return (0);
+}
+
+/* One iteration of the coefficients along Z, highest degree first so the
+ lower ones are still those of the previous iteration. */
+static void	ft_series_step(t_fexp (*b)[2], double zr, double zi, t_fexp r)
+{
+	t_fexp	re;
+	t_fexp	im;
+	int		k;
+	int		i;
+
+	k = SA_TERMS;
+	while (--k >= 0)
+	{
+		re = fe_sub(fe_mul_d(b[k][0], 2 * zr), fe_mul_d(b[k][1], 2 * zi));
+		im = fe_add(fe_mul_d(b[k][1], 2 * zr), fe_mul_d(b[k][0], 2 * zi));
+		i = -1;
+		while (++i < k)
+		{
+			re = fe_add(re, fe_sub(fe_mul(b[i][0], b[k - 1 - i][0]),
+						fe_mul(b[i][1], b[k - 1 - i][1])));
+			im = fe_add(im, fe_add(fe_mul(b[i][0], b[k - 1 - i][1]),
+						fe_mul(b[i][1], b[k - 1 - i][0])));
+		}
+		if (k == 0)
+			re = fe_add(re, r);
+		b[k][0] = re;
+		b[k][1] = im;
+	}
+}
+
+/* d = (re, im) u, in place. */
+static void	ft_series_mul(t_fexp *d, const double *u)
+{
+	t_fexp	re;
+
+	re = fe_sub(fe_mul_d(d[0], u[0]), fe_mul_d(d[1], u[1]));
+	d[1] = fe_add(fe_mul_d(d[0], u[1]), fe_mul_d(d[1], u[0]));
+	d[0] = re;
+}
+
+/* d = sum of b[k] u^(k+1), by Horner. */
+static void	ft_series_eval(t_fexp (*b)[2], const double *u, t_fexp *d)
+{
+	int		k;
+
+	d[0] = b[SA_TERMS - 1][0];
+	d[1] = b[SA_TERMS - 1][1];
+	k = SA_TERMS - 1;
+	while (k-- > 0)
+	{
+		ft_series_mul(d, u);
+		d[0] = fe_add(d[0], b[k][0]);
+		d[1] = fe_add(d[1], b[k][1]);
+	}
+	ft_series_mul(d, u);
+}
+
+/* Advances the probe (u, d) to iteration n + 1 with the exact perturbation
+ and checks the series against it there. */
+static int	ft_series_probe(const t_frame *fr, t_fexp (*b)[2], const double *u,
+		t_fexp *d, int n)
+{
+	const t_orbit	*o;
+	t_fexp			s[2];
+	double			t[2];
+	t_fexp			err;
+
+	o = fr->orbit;
+	t[0] = 2 * o->re[n] + fe_to_d(d[0]);
+	t[1] = 2 * o->im[n] + fe_to_d(d[1]);
+	ft_series_mul(d, t);
+	d[0] = fe_add(d[0], fe_mul_d(o->fradius, u[0]));
+	d[1] = fe_add(d[1], fe_mul_d(o->fradius, u[1]));
+	ft_series_eval(b, u, s);
+	s[0] = fe_sub(s[0], d[0]);
+	s[1] = fe_sub(s[1], d[1]);
+	err = fe_add(fe_mul(s[0], s[0]), fe_mul(s[1], s[1]));
+	if (fe_less(fe_mul_d(fe_add(fe_mul(d[0], d[0]), fe_mul(d[1], d[1])),
+				SA_TOLERANCE * SA_TOLERANCE), err))
+		return (0);
+	t[0] = o->re[n + 1] + fe_to_d(d[0]);
+	t[1] = o->im[n + 1] + fe_to_d(d[1]);
+	return (t[0] * t[0] + t[1] * t[1] < fr->bailout);
+}
+
+/* Coefficients of the previous fit, at o->skip, carried from its radius
+ was to the new one. Only when the view lies inside the one they were
+ fitted on (o->box, in units of the old radius): the probes there held up
+ to skip, so the fit can go on from it. Returns the iteration the fit
+ starts from, 0 with b untouched otherwise. */
+static int	ft_series_resume(const t_frame *fr, t_orbit *o, const t_fexp *was,
+		const double *box)
+{
+	t_fexp	ratio;
+	t_fexp	p;
+	double	r;
+	int		k;
+
+	if (!was || o->skip + 1 >= fr->iteration || was->m == 0)
+		return (0);
+	ratio = fe_norm(o->fradius.m / was->m, o->fradius.e - was->e);
+	r = fe_to_d(ratio);
+	if (!(r > 0 && box[0] * r >= o->box[0] && box[1] * r <= o->box[1]
+			&& box[2] * r >= o->box[2] && box[3] * r <= o->box[3]))
+		return (0);
+	p = ratio;
+	k = -1;
+	while (++k < SA_TERMS)
+	{
+		o->fcoef[k][0] = fe_mul(o->fcoef[k][0], p);
+		o->fcoef[k][1] = fe_mul(o->fcoef[k][1], p);
+		p = fe_mul(p, ratio);
+	}
+	return (o->skip);
+}
+
+/* Finds the last iteration where the series matches every probe, the
+ corners and side midpoints of the view seen from the reference, and keeps
+ its coefficients in the orbit. was: radius of the previous fit of the
+ same reference, NULL for a new one. A fit that resumes starts the probes
+ from the series itself. */
+static void	ft_series_fit(const t_frame *fr, t_orbit *o, const t_fexp *was,
+		const int *size)
+{
+	static const double	dir[SA_PROBES][2] = {{-1, -1}, {1, -1}, {-1, 1},
+		{1, 1}, {-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+	t_fexp				b[SA_TERMS][2];
+	double				u[SA_PROBES][2];
+	t_fexp				d[SA_PROBES][2];
+	double				box[4];
+	int					n;
+	int					p;
+
+	box[0] = -o->px / o->half;
+	box[1] = (size[0] - o->px) / o->half;
+	box[2] = -o->py / o->half;
+	box[3] = (size[1] - o->py) / o->half;
+	n = ft_series_resume(fr, o, was, box);
+	p = -1;
+	while (n == 0 && ++p < SA_TERMS * 2)
+		o->fcoef[p / 2][p % 2] = fe_from(0);
+	ft_memcpy(o->box, box, sizeof(box));
+	ft_memcpy(b, o->fcoef, sizeof(b));
+	p = -1;
+	while (++p < SA_PROBES)
+	{
+		u[p][0] = ((dir[p][0] + 1) * size[0] / 2 - o->px) / o->half;
+		u[p][1] = ((dir[p][1] + 1) * size[1] / 2 - o->py) / o->half;
+		d[p][0] = fe_from(0);
+		d[p][1] = fe_from(0);
+		if (n)
+			ft_series_eval(b, u[p], d[p]);
+	}
+	o->skip = n;
+	while (n + 1 < o->length && n + 1 < fr->iteration)
+	{
+		ft_series_step(b, o->re[n], o->im[n], o->fradius);
+		p = -1;
+		while (++p < SA_PROBES && ft_series_probe(fr, b, u[p], d[p], n))
+			;
+		if (p < SA_PROBES)
+			break ;
+		n++;
+		ft_memcpy(o->fcoef, b, sizeof(b));
+		o->skip = n;
+	}
+	n = -1;
+	while (++n < SA_TERMS * 2)
+		o->coef[n / 2][n % 2] = fe_to_d(o->fcoef[n / 2][n % 2]);
+}
+
+/* Keeps the reference of the previous frame if it still serves this one:
+ computed at this bailout with at least the limbs the scale asks for, and
+ still inside the view. Its position in the view goes to o->px, o->py. */
+static int	ft_orbit_cached(t_fractol *f, t_orbit *o, int limbs)
+{
+	t_big	c;
+	t_big	d;
+	t_fexp	scale;
+	double	pos[2];
+	int		e;
+	int		k;
+
+	if (!o->reach || o->limbs < limbs || o->bailout != f->frame.bailout)
+		return (1);
+	scale.m = frexpl(f->fractal.scale, &e);
+	scale.e = e;
+	k = -1;
+	while (++k < 2)
+	{
+		ft_big_resize(&c, &o->big->c[k], BIG_LIMBS);
+		ft_big_sub(&d, &c, &f->fractal.center[k]);
+		pos[k] = fe_to_d(fe_mul(ft_big_to_fexp(&d), scale));
+	}
+	pos[0] += f->mlx.width / 2.0;
+	pos[1] += f->mlx.height / 2.0;
+	if (!(pos[0] >= 0 && pos[0] <= f->mlx.width
+			&& pos[1] >= 0 && pos[1] <= f->mlx.height))
+		return (1);
+	o->px = pos[0];
+	o->py = pos[1];
+	return (0);
+}
+
+/* Reference orbit and series of the frame. The reference of the previous
+ frame is kept while it lies in the view, carried on if the iteration
+ count grew past it (ft_orbit_cached); otherwise a new one is computed at
+ the exact center of the view (fractal.center) at log2(scale) + BIG_GUARD
+ bits. The radius reaches the farthest corner from the reference and comes
+ from the long double scale: past FEXP_SCALE_LIMIT the deltas start in
+ floatexp (perturb_fexp). Series and table are kept too when nothing they
+ depend on moved. Called by ft_frame_setup once the frame is filled in. */
+int	ft_orbit_setup(t_fractol *f)
+{
+	t_orbit		*o;
+	t_fexp		was;
+	double		view[3];
+	long double	radius;
+	int			e;
+
+	o = &f->orbit;
+	was = o->fradius;
+	view[0] = o->px;
+	view[1] = o->py;
+	view[2] = o->half;
+	if (ft_orbit_cached(f, o, ft_big_limbs(f->fractal.scale)) != 0)
+	{
+		o->px = f->mlx.width / 2.0;
+		o->py = f->mlx.height / 2.0;
+		o->limbs = ft_big_limbs(f->fractal.scale);
+		o->fitted = 0;
+		was.m = 0;
+		if (ft_orbit_reference(o, &f->frame, f->fractal.center,
+				f->pool.count > 0) != 0)
+			return (1);
+	}
+	else if (o->length == o->reach && o->reach < f->frame.iteration)
+	{
+		o->fitted = 0;
+		if (ft_orbit_reference(o, &f->frame, NULL, f->pool.count > 0) != 0)
+			return (1);
+	}
+	o->half = hypot(fmax(o->px, f->mlx.width - o->px),
+			fmax(o->py, f->mlx.height - o->py));
+	radius = o->half / f->fractal.scale;
+	o->radius = radius;
+	o->fradius.m = frexpl(radius, &e);
+	o->fradius.e = e;
+	o->fexp = (f->fractal.scale >= FEXP_SCALE_LIMIT);
+	f->frame.orbit = o;
+	if (o->fitted == f->frame.iteration && o->px == view[0]
+		&& o->py == view[1] && o->half == view[2]
+		&& o->fradius.m == was.m && o->fradius.e == was.e)
+		return (0);
+	ft_series_fit(&f->frame, o, &was,
+		(int [2]){f->mlx.width, f->mlx.height});
+	ft_bla_build(o, BLA_MEMORY / 2);
+	o->fitted = f->frame.iteration;
+	return (0);
+}
+
+/* Extra reference at pixel (px, py) of the frame, for the pixels the main
+ one leaves glitched (glitch.c). Same precision as the main reference, the
+ radius out to the farthest corner of the view so the BLA table holds for
+ every pixel, a BLA table in its share of BLA_MEMORY and no series: its
+ pixels are few and start from 0. Runs inside a pool job; spare as for
+ ft_orbit_reference. */
+int	ft_orbit_extra(t_fractol *f, t_orbit *o, int px, int py, int spare)
+{
+	t_big		c[2];
+	t_big		d;
+	long double	radius;
+	int			e;
+
+	o->px = px;
+	o->py = py;
+	o->limbs = f->orbit.limbs;
+	o->half = hypot(fmax(px, f->mlx.width - px), fmax(py, f->mlx.height - py));
+	radius = o->half / f->fractal.scale;
+	o->radius = radius;
+	o->fradius.m = frexpl(radius, &e);
+	o->fradius.e = e;
+	o->fexp = f->orbit.fexp;
+	o->skip = 0;
+	ft_big_from_ld(&d, (px - f->mlx.width / 2.0L) / f->fractal.scale,
+		BIG_LIMBS);
+	ft_big_add(&c[0], &f->fractal.center[0], &d);
+	ft_big_from_ld(&d, (py - f->mlx.height / 2.0L) / f->fractal.scale,
+		BIG_LIMBS);
+	ft_big_add(&c[1], &f->fractal.center[1], &d);
+	if (ft_orbit_reference(o, &f->frame, c, spare) != 0)
+		return (1);
+	ft_bla_build(o, BLA_MEMORY / 2 / GLITCH_REFS);
+	return (0);
+}
+
+/* Starting d of the lanes: the series at skip, or 0 at iteration 0. */
+static void	perturb_start(const t_orbit *o, const t_vd *u, t_vd *d, int skip)
+{
+	t_vd	re;
+	int		k;
+
+	d[0] = (t_vd){0};
+	d[1] = (t_vd){0};
+	if (!skip)
+		return ;
+	d[0] += o->coef[SA_TERMS - 1][0];
+	d[1] += o->coef[SA_TERMS - 1][1];
+	k = SA_TERMS - 1;
+	while (k-- > 0)
+	{
+		re = d[0] * u[0] - d[1] * u[1] + o->coef[k][0];
+		d[1] = d[0] * u[1] + d[1] * u[0] + o->coef[k][1];
+		d[0] = re;
+	}
+	cmul_d(d, u);
+}
+
+/* d = d t + c on floatexp lanes, t in double; d t alone without c. */
+static void	perturb_fexp_step(t_vfexp *d, const t_vd *t, const t_vfexp *c)
+{
+	t_vfexp	re;
+	t_vfexp	im;
+
+	re = vfe_add(vfe_mul_vd(d[0], t[0]), vfe_mul_vd(d[1], -t[1]));
+	im = vfe_add(vfe_mul_vd(d[0], t[1]), vfe_mul_vd(d[1], t[0]));
+	d[0] = re;
+	d[1] = im;
+	if (!c)
+		return ;
+	d[0] = vfe_add(d[0], c[0]);
+	d[1] = vfe_add(d[1], c[1]);
+}
+
+/* Floatexp phase of a deep frame: the series at skip (nm[0]), then d
+ iterated while it is below the double range, 2^FEXP_SWITCH, in some lane.
+ Stops early on an escape, left to the double loop. Leaves in nm the
+ iteration and the reference index reached, d in double. */
+static void	perturb_fexp(const t_frame *fr, const t_vd *u, t_vd *d, int *nm)
+{
+	const t_orbit	*o;
+	t_vfexp			fd[2];
+	t_vfexp			dc[2];
+	t_vd			t[2];
+	int				n;
+
+	o = fr->orbit;
+	dc[0] = vfe_norm(u[0] * o->fradius.m, (t_vmd){0} + o->fradius.e);
+	dc[1] = vfe_norm(u[1] * o->fradius.m, (t_vmd){0} + o->fradius.e);
+	fd[0] = vfe_broadcast(o->fcoef[SA_TERMS - 1][0]);
+	fd[1] = vfe_broadcast(o->fcoef[SA_TERMS - 1][1]);
+	n = SA_TERMS - 1;
+	while (n-- > 0)
+		perturb_fexp_step(fd, u, (t_vfexp[2]){vfe_broadcast(o->fcoef[n][0]),
+			vfe_broadcast(o->fcoef[n][1])});
+	perturb_fexp_step(fd, u, NULL);
+	fd[0] = vfe_norm(fd[0].m * (nm[0] != 0), fd[0].e);
+	fd[1] = vfe_norm(fd[1].m * (nm[0] != 0), fd[1].e);
+	while (nm[0] < fr->iteration)
+	{
+		d[0] = vfe_to_vd(fd[0]);
+		d[1] = vfe_to_vd(fd[1]);
+		t[0] = o->re[nm[1]] + d[0];
+		t[1] = o->im[nm[1]] + d[1];
+		if (vmd_any(t[0] * t[0] + t[1] * t[1] >= fr->bailout)
+			|| !vmd_any((fd[0].e < FEXP_SWITCH) & (fd[1].e < FEXP_SWITCH)))
+			return ;
+		t[0] = 2 * o->re[nm[1]] + d[0];
+		t[1] = 2 * o->im[nm[1]] + d[1];
+		perturb_fexp_step(fd, t, dc);
+		nm[0]++;
+		if (++nm[1] < o->length)
+			continue ;
+		fd[0] = vfe_from(vfe_to_vd(fd[0]) + o->re[nm[1]]);
+		fd[1] = vfe_from(vfe_to_vd(fd[1]) + o->im[nm[1]]);
+		nm[1] = 0;
+	}
+	d[0] = vfe_to_vd(fd[0]);
+	d[1] = vfe_to_vd(fd[1]);
+}
+
+/* Longest jump of the table starting at index m, at most left iterations
+ long, whose radius holds d of every lane still iterating; NULL if none.
+ The shortest level has the widest radius and fails fast. */
+static const t_bla	*perturb_jump(const t_orbit *o, const t_vd *d, t_vmd in,
+		int m, int left, int *steps)
+{
+	const t_bla	*e;
+	const t_bla	*next;
+	t_vd		d2;
+	int			l;
+
+	l = o->bla_base;
+	if (m < 1 || ((m - 1) & ((1 << l) - 1)) || (1 << l) > left
+		|| (m - 1) >> l >= o->bla_count[l])
+		return (NULL);
+	e = &o->bla[o->bla_first[l] + ((m - 1) >> l)];
+	d2 = d[0] * d[0] + d[1] * d[1];
+	if (vmd_any(in & (d2 >= e->r2)))
+		return (NULL);
+	while (++l < o->bla_levels && !((m - 1) & ((1 << l) - 1))
+		&& (1 << l) <= left && (m - 1) >> l < o->bla_count[l])
+	{
+		next = &o->bla[o->bla_first[l] + ((m - 1) >> l)];
+		if (vmd_any(in & (d2 >= next->r2)))
+			break ;
+		e = next;
+	}
+	*steps = 1 << (l - 1);
+	return (e);
+}
+
+/* Next d of the lanes: the linear jump when there is one, a perturbation
+ step at index m otherwise. */
+static void	perturb_advance(const t_orbit *o, t_vd *d, const t_vd *dc,
+		t_vmd in, const t_bla *jump, int m)
+{
+	t_vd	z[2];
+
+	if (jump)
+	{
+		z[0] = d[0] * jump->a[0] - d[1] * jump->a[1]
+			+ dc[0] * jump->b[0] - dc[1] * jump->b[1];
+		z[1] = d[0] * jump->a[1] + d[1] * jump->a[0]
+			+ dc[0] * jump->b[1] + dc[1] * jump->b[0];
+	}
+	else
+	{
+		z[0] = 2 * o->re[m] + d[0];
+		z[1] = 2 * o->im[m] + d[1];
+		cmul_d(z, d);
+		z[0] += dc[0];
+		z[1] += dc[1];
+	}
+	d[0] = vd_select(in, z[0], d[0]);
+	d[1] = vd_select(in, z[1], d[1]);
+}
+
+/* Iterates one group of lanes, at u in units of the radius, from skip (from
+ where the floatexp phase stops in a deep frame). Returns 1 without writing
+ when a lane has already escaped at skip: the series is not valid there.
+ z_n is Z_m + d, m the index in the reference, restarting at 0 on a rebase.
+ After a missed jump the table is looked up again only after wait steps,
+ doubling up to BLA_BACKOFF: once d has outgrown the radii the lookups
+ would cost more than the steps. */
+static int	perturb_lanes(const t_frame *fr, const t_row *row, const t_vd *u,
+		int i, int skip)
+{
+	const t_orbit	*o;
+	t_vd			d[2];
+	t_vd			dc[2];
+	t_vd			z[2];
+	t_vd			mag;
+	t_vmd			in;
+	t_vmd			glitch;
+	t_vmd			depth;
+	const t_bla		*jump;
+	int				n;
+	int				m;
+	int				steps;
+	int				wait[2];
+	int				nm[2];
+
+	o = fr->orbit;
+	dc[0] = u[0] * o->radius;
+	dc[1] = u[1] * o->radius;
+	nm[0] = skip;
+	nm[1] = skip;
+	if (o->fexp)
+		perturb_fexp(fr, u, d, nm);
+	else
+		perturb_start(o, u, d, skip);
+	n = nm[0];
+	m = nm[1];
+	wait[0] = 0;
+	wait[1] = 1;
+	mag = (t_vd){0};
+	in = ((t_vmd){0} == 0);
+	glitch = (t_vmd){0};
+	depth = (t_vmd){0} + n;
+	while (n < fr->iteration)
+	{
+		z[0] = o->re[m] + d[0];
+		z[1] = o->im[m] + d[1];
+		mag = vd_select(in, z[0] * z[0] + z[1] * z[1], mag);
+		glitch |= in & (mag < GLITCH_TOLERANCE
+				* (o->re[m] * o->re[m] + o->im[m] * o->im[m]));
+		in &= (mag < fr->bailout);
+		if (n == skip && skip && vmd_any(~in))
+			return (1);
+		if (!vmd_any(in))
+			break ;
+		jump = NULL;
+		if (o->bla_levels && --wait[0] <= 0)
+		{
+			jump = perturb_jump(o, d, in, m, fr->iteration - n, &steps);
+			wait[1] *= 2;
+			if (jump || wait[1] > BLA_BACKOFF)
+				wait[1] = (jump == NULL) * BLA_BACKOFF + (jump != NULL);
+			wait[0] = wait[1];
+		}
+		if (!jump)
+			steps = 1;
+		perturb_advance(o, d, dc, in, jump, m);
+		depth -= in * steps;
+		n += steps;
+		m += steps;
+		if (m < o->length)
+			continue ;
+		d[0] += o->re[m];
+		d[1] += o->im[m];
+		m = 0;
+	}
+	n = -1;
+	while (++n < VD_LANES && i + n < row->count)
+		row->out[i + n] = escape_value(fr, depth[n], mag[n]);
+	n = -1;
+	while (row->glitch && ++n < VD_LANES && i + n < row->count)
+		row->glitch[i + n] = (glitch[n] != 0);
+	return (0);
+}
+
+/*
+ * Kernel del Mandelbrot perturbato: le coordinate della riga sono gia'
+ * relative al riferimento e in unita' del raggio (ft_frame_row), cioe'
+ * u = dc / radius, che resta in double a ogni profondita'. Il modo
+ * (z² + c) e' uno solo, quindi non passa da row_d.
+ */
+void	perturb_d(const t_frame *fr, const t_row *row)
+{
+	t_vd	lane;
+	t_vd	u[2];
+	int		i;
+
+	i = -1;
+	while (++i < VD_LANES)
+		lane[i] = i;
+	i = 0;
+	while (i < row->count)
+	{
+		u[0] = row->re + (lane + i) * row->step;
+		u[1] = (t_vd){0} + row->im;
+		if (perturb_lanes(fr, row, u, i, fr->orbit->skip) != 0)
+			perturb_lanes(fr, row, u, i, 0);
+		i += VD_LANES;
+	}
+}
@@ -0,0 +1,139 @@
+#include "../includes/fractol.h"
+
+/*
+ * PNG - Codifica l'immagine del frame (f->mlx.addr, 32 bit per pixel) come
+ * PNG RGB a 8 bit, per le tile del server (server.c). Non c'e' zlib: lo
+ * stream deflate e' fatto di blocchi "stored", non compressi, da al massimo
+ * 65535 byte, con l'header zlib e l'Adler-32 in coda. Le tile sono piccole
+ * e viaggiano su un socket locale, quindi la compressione non varrebbe il
+ * tempo che costa; il file resta un PNG valido per qualsiasi lettore.
+ *
+ * I colori sono quelli della finestra: il pixel e' letto nel layout di X11
+ * (blu nel byte basso) come lo scrive ft_pack_rgb con endian 0.
+ */
+
+static void	ft_png_u32(unsigned char *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static uint32_t	ft_png_crc(const unsigned char *p, size_t n)
+{
+	uint32_t	c;
+	int			k;
+
+	c = 0xFFFFFFFF;
+	while (n--)
+	{
+		c ^= *p++;
+		k = -1;
+		while (++k < 8)
+			c = (c >> 1) ^ (0xEDB88320 & -(c & 1));
+	}
+	return (~c);
+}
+
+/* Chunk of type name with the n bytes already at p + 8, the length, type
+ and CRC around them. Returns the chunk size. */
+static size_t	ft_png_chunk(unsigned char *p, const char *name, size_t n)
+{
+	ft_png_u32(p, n);
+	ft_memcpy(p + 4, name, 4);
+	ft_png_u32(p + 8 + n, ft_png_crc(p + 4, n + 4));
+	return (n + 12);
+}
+
+/* Filtered scanlines (filter 0, then R G B) at raw, h (1 + 3 w) bytes. */
+static void	ft_png_rows(t_fractol *f, unsigned char *raw)
+{
+	uint32_t	px;
+	int			x;
+	int			y;
+
+	y = -1;
+	while (++y < f->mlx.height)
+	{
+		*raw++ = 0;
+		x = -1;
+		while (++x < f->mlx.width)
+		{
+			px = *(uint32_t *)(f->mlx.addr + y * f->mlx.line_length + x * 4);
+			*raw++ = px >> 16;
+			*raw++ = px >> 8;
+			*raw++ = px;
+		}
+	}
+}
+
+/* zlib stream of stored blocks holding the n bytes at raw, written at p.
+ Returns its size. */
+static size_t	ft_png_deflate(unsigned char *p, const unsigned char *raw,
+			size_t n)
+{
+	uint32_t	a;
+	uint32_t	b;
+	size_t		at;
+	size_t		len;
+	size_t		k;
+
+	p[0] = 0x78;
+	p[1] = 0x01;
+	at = 2;
+	k = 0;
+	while (k < n)
+	{
+		len = n - k;
+		if (len > 65535)
+			len = 65535;
+		p[at] = (k + len == n);
+		p[at + 1] = len;
+		p[at + 2] = len >> 8;
+		p[at + 3] = ~len;
+		p[at + 4] = ~len >> 8;
+		ft_memcpy(p + at + 5, raw + k, len);
+		at += 5 + len;
+		k += len;
+	}
+	a = 1;
+	b = 0;
+	k = -1;
+	while (++k < n)
+	{
+		a = (a + raw[k]) % 65521;
+		b = (b + a) % 65521;
+	}
+	ft_png_u32(p + at, (b << 16) | a);
+	return (at + 4);
+}
+
+/* PNG of the frame image, malloc'd, its size in *size. NULL on failure. */
+unsigned char	*ft_png_encode(t_fractol *f, size_t *size)
+{
+	unsigned char	*png;
+	unsigned char	*raw;
+	size_t			n;
+
+	n = (size_t)f->mlx.height * (1 + 3 * (size_t)f->mlx.width);
+	raw = malloc(n);
+	png = malloc(8 + 25 + 12 + 6 + n + 5 * (n / 65535 + 1) + 12);
+	if (!raw || !png)
+	{
+		free(raw);
+		free(png);
+		return (NULL);
+	}
+	ft_png_rows(f, raw);
+	ft_memcpy(png, "\x89PNG\r\n\x1a\n", 8);
+	ft_png_u32(png + 16, f->mlx.width);
+	ft_png_u32(png + 20, f->mlx.height);
+	ft_memcpy(png + 24, "\x08\x02\x00\x00\x00", 5);
+	*size = 8 + ft_png_chunk(png + 8, "IHDR", 13);
+	*size += ft_png_chunk(png + *size, "IDAT",
+			ft_png_deflate(png + *size + 8, raw, n));
+	*size += ft_png_chunk(png + *size, "IEND", 0);
+	free(raw);
+	return (png);
+}
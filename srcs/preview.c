@@ -0,0 +1,156 @@
+#include "../includes/fractol.h"
+
+/*
+ * ANTEPRIMA JULIA - Mentre si guarda Mandelbrot, ogni punto c sotto il
+ * mouse e' la costante di un insieme di Julia. L'anteprima lo mostra in
+ * un riquadro nell'angolo in alto a destra, largo 1/PREVIEW_DIV della
+ * finestra e calcolato a risoluzione ridotta (un campione ogni
+ * PREVIEW_RES x PREVIEW_RES pixel, al massimo PREVIEW_ITER iterazioni,
+ * kernel float): cosi' si aggiorna a ogni frame mentre il mouse si muove.
+ * Il riquadro viene disegnato sopra l'immagine quando il frame principale
+ * e' completo; un clic sinistro apre il Julia di quella c.
+ */
+
+int	ft_preview_active(t_fractol *f)
+{
+	return (f->preview.enabled && f->fractal.type == 2);
+}
+
+/* Frame of the inset: the main frame with the Julia kernel, the constant
+ under the mouse and a view of PREVIEW_SPAN units centred on 0. */
+static int	ft_preview_setup(t_fractol *f)
+{
+	t_preview	*pv;
+	float		*values;
+
+	pv = &f->preview;
+	pv->w = f->mlx.width / PREVIEW_DIV / PREVIEW_RES;
+	pv->h = f->mlx.height / PREVIEW_DIV / PREVIEW_RES;
+	if (pv->w < 1 || pv->h < 1)
+		return (1);
+	if (pv->w * pv->h > pv->cap)
+	{
+		values = malloc(sizeof(float) * pv->w * pv->h);
+		if (!values)
+			return (1);
+		free(pv->values);
+		pv->values = values;
+		pv->cap = pv->w * pv->h;
+	}
+	pv->x = f->mlx.width - pv->w * PREVIEW_RES - 10;
+	pv->y = 10;
+	pv->frame = f->frame;
+	pv->frame.kernel = ft_kernel_lookup(1, 2, PREC_FLOAT)->kernel;
+	pv->frame.precision = PREC_FLOAT;
+	pv->frame.de = 0;
+	pv->frame.orbit = NULL;
+	pv->frame.step = PREVIEW_SPAN / pv->w;
+	pv->frame.scale = 1.0 / pv->frame.step;
+	pv->frame.offset_x = -PREVIEW_SPAN / 2;
+	pv->frame.offset_y = -pv->h * pv->frame.step / 2;
+	pv->frame.jr = pv->cr;
+	pv->frame.ji = pv->ci;
+	if (pv->frame.iteration > PREVIEW_ITER)
+		pv->frame.iteration = PREVIEW_ITER;
+	return (0);
+}
+
+/* Pool job: one row of samples, each painted as a PREVIEW_RES block. */
+static void	ft_preview_row(void *arg, int index, int thread)
+{
+	t_fractol	*f;
+	t_preview	*pv;
+	t_row		row;
+	uint32_t	px;
+	int			r;
+	int			x;
+
+	(void)thread;
+	f = arg;
+	pv = &f->preview;
+	row.count = pv->w;
+	row.out = pv->values + index * pv->w;
+	row.dist = NULL;
+	row.glitch = NULL;
+	ft_frame_row(&pv->frame, 0, index, &row);
+	r = -1;
+	while (++r < PREVIEW_RES)
+	{
+		x = -1;
+		while (++x < pv->w * PREVIEW_RES)
+		{
+			px = 0;
+			if (pv->values[index * pv->w + x / PREVIEW_RES]
+				< pv->frame.iteration)
+				px = f->palette.lut[(int)(pv->values[index * pv->w
+						+ x / PREVIEW_RES] * f->palette.steps)];
+			ft_put_word(f, pv->x + x, pv->y + index * PREVIEW_RES + r, px);
+		}
+	}
+}
+
+static void	ft_preview_border(t_fractol *f)
+{
+	t_preview	*pv;
+	int			i;
+
+	pv = &f->preview;
+	i = -2;
+	while (++i <= pv->w * PREVIEW_RES)
+	{
+		ft_put_word(f, pv->x + i, pv->y - 1, 0xFFFFFFFF);
+		ft_put_word(f, pv->x + i, pv->y + pv->h * PREVIEW_RES, 0xFFFFFFFF);
+	}
+	i = -2;
+	while (++i <= pv->h * PREVIEW_RES)
+	{
+		ft_put_word(f, pv->x - 1, pv->y + i, 0xFFFFFFFF);
+		ft_put_word(f, pv->x + pv->w * PREVIEW_RES, pv->y + i, 0xFFFFFFFF);
+	}
+}
+
+/* Renders the inset into the image over the finished main frame. */
+void	ft_preview_draw(t_fractol *f)
+{
+	f->preview.dirty = 0;
+	if (ft_preview_setup(f) != 0)
+		return ;
+	ft_pool_run(&f->pool, ft_preview_row, f, f->preview.h);
+	ft_preview_border(f);
+}
+
+/* Motion hook: the point under the mouse becomes the Julia constant. */
+int	preview_motion(int x, int y, t_fractol *f)
+{
+	if (!ft_preview_active(f))
+		return (0);
+	f->preview.cr = x / f->fractal.scale + f->fractal.offset_x;
+	f->preview.ci = y / f->fractal.scale + f->fractal.offset_y;
+	f->preview.dirty = 1;
+	return (0);
+}
+
+/* Left click on the Mandelbrot view: switches to the Julia set of the
+ point clicked, with the default Julia view. */
+void	preview_open(int x, int y, t_fractol *f)
+{
+	preview_motion(x, y, f);
+	f->fractal.type = 1;
+	f->fractal.cr = f->preview.cr;
+	f->fractal.ci = f->preview.ci;
+	f->fractal.custom_c = 1;
+	f->fractal.offset_x = -2.0;
+	f->fractal.offset_y = -1.30;
+	f->fractal.scale = 300.00;
+	ft_view_reset(f);
+	f->preview.enabled = 0;
+}
+
+void	toggle_preview(t_fractol *f)
+{
+	f->preview.enabled = !f->preview.enabled;
+	f->preview.cr = (f->mlx.width / 2) / f->fractal.scale
+		+ f->fractal.offset_x;
+	f->preview.ci = (f->mlx.height / 2) / f->fractal.scale
+		+ f->fractal.offset_y;
+}
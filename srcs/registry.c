@@ -0,0 +1,181 @@
+#include "../includes/fractol.h"
+
+/*
+ * Tabella dei kernel: per ogni tipo di frattale e precisione la funzione
+ * che calcola una riga. Viene consultata una volta per frame da
+ * ft_frame_setup, cosi' il ciclo sui pixel non ha piu' la catena di if
+ * sul tipo: aggiungere un frattale significa aggiungere righe qui.
+ * Le colonne sono tipo, grado della formula (la potenza n del Multibrot,
+ * 2 per gli altri), precisione, kernel, costante c di default dei Julia e
+ * funzioni supportate: stima della distanza (derivata dz nel ciclo di
+ * row_d, solo double) e orbit trap (row_d e row_f, non le formule).
+ * PREC_PERTURB e' il kernel per gli zoom oltre il double (perturb.c), che
+ * esiste solo per z² + c; gli altri tipi restano in double e non possono
+ * scendere oltre SCALE_LIMIT.
+ */
+static const t_kernel_entry	g_kernels[] = {
+	{1, 2, PREC_DOUBLE, julia_d, -0.8, 0.156, CAP_DE | CAP_TRAP},
+	{1, 2, PREC_FLOAT, julia_f, -0.8, 0.156, CAP_TRAP},
+	{2, 2, PREC_DOUBLE, mandelbrot_d, 0, 0, CAP_DE | CAP_TRAP},
+	{2, 2, PREC_FLOAT, mandelbrot_f, 0, 0, CAP_TRAP},
+	{2, 2, PREC_PERTURB, perturb_d, 0, 0, 0},
+	{3, 2, PREC_DOUBLE, julia_d, -0.0123, 0.745, CAP_DE | CAP_TRAP},
+	{3, 2, PREC_FLOAT, julia_f, -0.0123, 0.745, CAP_TRAP},
+	{4, 2, PREC_DOUBLE, monster_d, 0, 0, CAP_DE | CAP_TRAP},
+	{4, 2, PREC_FLOAT, monster_f, 0, 0, CAP_TRAP},
+	{5, 2, PREC_DOUBLE, mandelbrot_d, 0, 0, CAP_DE | CAP_TRAP},
+	{5, 2, PREC_FLOAT, mandelbrot_f, 0, 0, CAP_TRAP},
+	{5, 2, PREC_PERTURB, perturb_d, 0, 0, 0},
+	{5, 3, PREC_DOUBLE, multibrot3_d, 0, 0, CAP_DE | CAP_TRAP},
+	{5, 3, PREC_FLOAT, multibrot3_f, 0, 0, CAP_TRAP},
+	{5, 4, PREC_DOUBLE, multibrot4_d, 0, 0, CAP_DE | CAP_TRAP},
+	{5, 4, PREC_FLOAT, multibrot4_f, 0, 0, CAP_TRAP},
+	{5, 5, PREC_DOUBLE, multibrot5_d, 0, 0, CAP_DE | CAP_TRAP},
+	{5, 5, PREC_FLOAT, multibrot5_f, 0, 0, CAP_TRAP},
+	{5, 6, PREC_DOUBLE, multibrot6_d, 0, 0, CAP_DE | CAP_TRAP},
+	{5, 6, PREC_FLOAT, multibrot6_f, 0, 0, CAP_TRAP},
+	{5, 7, PREC_DOUBLE, multibrot7_d, 0, 0, CAP_DE | CAP_TRAP},
+	{5, 7, PREC_FLOAT, multibrot7_f, 0, 0, CAP_TRAP},
+	{5, 8, PREC_DOUBLE, multibrot8_d, 0, 0, CAP_DE | CAP_TRAP},
+	{5, 8, PREC_FLOAT, multibrot8_f, 0, 0, CAP_TRAP},
+	{6, 2, PREC_DOUBLE, ship_d, 0, 0, CAP_TRAP},
+	{6, 2, PREC_FLOAT, ship_f, 0, 0, CAP_TRAP},
+	{7, 2, PREC_DOUBLE, tricorn_d, 0, 0, CAP_TRAP},
+	{7, 2, PREC_FLOAT, tricorn_f, 0, 0, CAP_TRAP},
+	{8, 2, PREC_DOUBLE, celtic_d, 0, 0, CAP_TRAP},
+	{8, 2, PREC_FLOAT, celtic_f, 0, 0, CAP_TRAP},
+	{9, 2, PREC_DOUBLE, formula_d, 0, 0, 0},
+	{0, 0, 0, NULL, 0, 0, 0}
+};
+
+/* Entry for (type, power, precision), falling back to double precision when
+ the type has no kernel of the requested precision. NULL if unknown. */
+const t_kernel_entry	*ft_kernel_lookup(int type, int power, int precision)
+{
+	int	i;
+
+	i = -1;
+	while (g_kernels[++i].kernel)
+		if (g_kernels[i].type == type && g_kernels[i].power == power
+			&& g_kernels[i].precision == precision)
+			return (&g_kernels[i]);
+	if (precision != PREC_DOUBLE)
+		return (ft_kernel_lookup(type, power, PREC_DOUBLE));
+	return (NULL);
+}
+
+/* Single precision is enough while a pixel spans many float ulps, double
+ until DOUBLE_SCALE_LIMIT, perturbation past it. */
+int	ft_precision_for(t_fractol *f)
+{
+	if (f->fractal.scale < FLOAT_SCALE_LIMIT)
+		return (PREC_FLOAT);
+	if (f->fractal.scale < DOUBLE_SCALE_LIMIT)
+		return (PREC_DOUBLE);
+	return (PREC_PERTURB);
+}
+
+/* Deepest zoom of the current type: only the perturbed kernels go past the
+ double limit. */
+long double	ft_scale_limit(t_fractol *f)
+{
+	if (ft_kernel_lookup(f->fractal.type, f->fractal.power,
+			PREC_PERTURB)->precision == PREC_PERTURB)
+		return (DEEP_SCALE_LIMIT);
+	return (SCALE_LIMIT);
+}
+
+/* Terms of the trap distance (see trap_d): Re z = 0, Im z = 0, the origin
+ and the circle of radius TRAP_RADIUS, switched on by the trap shape. */
+static void	ft_frame_trap(t_frame *fr)
+{
+	fr->trap_off[0] = INFINITY;
+	fr->trap_off[1] = INFINITY;
+	fr->trap_off[2] = INFINITY;
+	fr->trap_off[3] = INFINITY;
+	if (fr->trap == TRAP_CROSS)
+		fr->trap_off[0] = 0;
+	if (fr->trap == TRAP_LINE || fr->trap == TRAP_CROSS)
+		fr->trap_off[1] = 0;
+	if (fr->trap == TRAP_POINT)
+		fr->trap_off[2] = 0;
+	if (fr->trap == TRAP_CIRCLE)
+		fr->trap_off[3] = 0;
+}
+
+/* Snapshot of the view for the frame about to be rendered: the worker
+ threads and the kernels only read this, never t_fractol. */
+void	ft_frame_setup(t_fractol *f)
+{
+	const t_kernel_entry	*entry;
+	t_frame					*fr;
+
+	fr = &f->frame;
+	fr->precision = ft_precision_for(f);
+	if (f->render.de && fr->precision == PREC_FLOAT)
+		fr->precision = PREC_DOUBLE;
+	entry = ft_kernel_lookup(f->fractal.type, f->fractal.power,
+			fr->precision);
+	fr->kernel = entry->kernel;
+	fr->de = f->render.de && (entry->caps & CAP_DE);
+	fr->trap = TRAP_NONE;
+	if (entry->caps & CAP_TRAP)
+		fr->trap = f->render.trap;
+	ft_frame_trap(fr);
+	fr->log2_power = log2(entry->power);
+	fr->program = &f->formula;
+	if (f->fractal.type == 9)
+		fr->log2_power = log2(f->formula.degree);
+	if (f->fractal.type == 9 && f->jit.kernel)
+		fr->kernel = f->jit.kernel;
+	fr->scale = f->fractal.scale;
+	fr->step = 1.0 / f->fractal.scale;
+	fr->offset_x = f->fractal.offset_x;
+	fr->offset_y = f->fractal.offset_y;
+	fr->cr = f->fractal.cr;
+	fr->ci = f->fractal.ci;
+	fr->jr = entry->cr;
+	fr->ji = entry->ci;
+	if (f->fractal.custom_c)
+	{
+		fr->jr = fr->cr;
+		fr->ji = fr->ci;
+	}
+	fr->bailout = f->fractal.bailout;
+	if (fr->de && fr->bailout < SMOOTH_BAILOUT)
+		fr->bailout = SMOOTH_BAILOUT;
+	fr->iteration = f->fractal.iteration;
+	fr->smooth = f->fractal.smooth;
+	fr->orbit = NULL;
+	if (entry->precision == PREC_PERTURB && ft_orbit_setup(f) != 0)
+		fr->kernel = ft_kernel_lookup(f->fractal.type, f->fractal.power,
+				PREC_DOUBLE)->kernel;
+}
+
+/* Runs the frame kernel on row->count pixels starting at pixel (px, py),
+ which may be fractional (anti-aliasing sub-samples). The caller sets count,
+ out and dist; the coordinates are filled in here, relative to the reference
+ and in units of its radius in a perturbed frame. */
+void	ft_frame_row(const t_frame *fr, double px, double py, t_row *row)
+{
+	row->re = px * fr->step + fr->offset_x;
+	row->step = fr->step;
+	row->im = py * fr->step + fr->offset_y;
+	if (fr->orbit)
+	{
+		row->re = (px - fr->orbit->px) / fr->orbit->half;
+		row->step = 1.0 / fr->orbit->half;
+		row->im = (py - fr->orbit->py) / fr->orbit->half;
+	}
+	fr->kernel(fr, row);
+}
+
+/* Next Multibrot exponent, from 2 to MAX_POWER and back. */
+void	next_power(t_fractol *f)
+{
+	if (f->fractal.type != 5)
+		return ;
+	f->fractal.power++;
+	if (f->fractal.power > MAX_POWER)
+		f->fractal.power = 2;
+}
@@ -0,0 +1,488 @@
+#include "../includes/fractol.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/*
+ * SERVER DI TILE - Con "./fractol serve <socket>" il programma non apre
+ * finestre: ascolta su un socket Unix e calcola tile per altri programmi
+ * locali (un visore a mappa, script batch) che non linkano fractol.
+ *
+ * PROTOCOLLO - una richiesta per riga:
+ *
+ *   <tipo> <iterazioni> <z>/<x>/<y> <raw|png> [cr ci | formula]
+ *
+ * - la mappa a zoom 0 e' una tile di SERVER_TILE pixel che copre 4 x 4
+ *   attorno al centro della vista iniziale del tipo; a zoom z ci sono
+ *   2^z x 2^z tile, x verso destra e y verso il basso come sullo schermo
+ * - cr ci danno la c dei Julia; per il tipo 9 il resto della riga e' la
+ *   formula
+ * - la risposta e' "OK z/x/y <byte>\n" seguita dalla tile, oppure
+ *   "ERR <motivo>\n". raw sono SERVER_TILE² float (i valori di fuga,
+ *   nell'ordine di byte della macchina), png l'immagine con la palette
+ *   della finestra. Un client puo' mandare piu' richieste di fila: le
+ *   risposte portano z/x/y perche' possono arrivare in un altro ordine
+ *
+ * CICLO - ogni giro legge tutto quello che i client hanno mandato e
+ * raccoglie le richieste in un batch di al massimo SERVER_BATCH tile
+ * distinte: richieste uguali (da client diversi o ripetute) diventano una
+ * sola tile con piu' destinatari. Poi le tile del batch si calcolano una
+ * per volta con ft_render_image, ognuna con le righe distribuite su tutto
+ * il pool, e passano dalla cache e dallo store di tile (tiles.c,
+ * store.c) come i frame della finestra: le tile gia' viste tornano subito.
+ *
+ * I socket dei client non bloccano: le risposte vanno in una coda per
+ * client, svuotata quando il socket accetta byte (POLLOUT), cosi' un client
+ * che non legge non ferma gli altri. Chi lascia piu' di SERVER_QUEUE byte
+ * in coda (un batch pieno di tile raw ci sta) viene chiuso.
+ */
+
+/* Listening socket at path; a socket left there by an old run is
+ replaced, anything else is not touched. */
+static int	ft_serve_listen(const char *path)
+{
+	struct sockaddr_un	addr;
+	struct stat			st;
+	int					fd;
+
+	if (ft_strlen(path) >= (int)sizeof(addr.sun_path))
+		return (-1);
+	ft_bzero(&addr, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	ft_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return (-1);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+		|| listen(fd, SERVER_CLIENTS) != 0)
+	{
+		close(fd);
+		return (-1);
+	}
+	return (fd);
+}
+
+/* Closes client c and frees its slot. */
+static void	ft_serve_drop(t_client *c)
+{
+	close(c->fd);
+	free(c->out);
+	ft_bzero(c, sizeof(*c));
+	c->fd = -1;
+}
+
+/* Sends what the socket of client c takes of its queue without blocking;
+ it is dropped on a write error. */
+static void	ft_serve_flush(t_client *c)
+{
+	ssize_t	w;
+
+	while (c->fd >= 0 && c->sent < c->out_len)
+	{
+		w = send(c->fd, c->out + c->sent, c->out_len - c->sent,
+				MSG_NOSIGNAL);
+		if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return ;
+		if (w <= 0)
+			ft_serve_drop(c);
+		else
+			c->sent += w;
+	}
+	c->out_len = 0;
+	c->sent = 0;
+}
+
+/* Room for n more bytes at the end of the queue of c, the sent bytes moved
+ out of the way. Returns 1 past SERVER_QUEUE or without memory. */
+static int	ft_serve_room(t_client *c, size_t n)
+{
+	char	*out;
+
+	if (c->sent)
+		ft_memmove(c->out, c->out + c->sent, c->out_len - c->sent);
+	c->out_len -= c->sent;
+	c->sent = 0;
+	if (c->out_len + n > SERVER_QUEUE)
+		return (1);
+	if (c->out_len + n <= c->out_cap)
+		return (0);
+	c->out_cap = 2 * (c->out_len + n);
+	if (c->out_cap > SERVER_QUEUE)
+		c->out_cap = SERVER_QUEUE;
+	out = malloc(c->out_cap);
+	if (!out)
+		return (1);
+	ft_memcpy(out, c->out, c->out_len);
+	free(c->out);
+	c->out = out;
+	return (0);
+}
+
+/* Queues n bytes for the client with that id, if still connected, and
+ sends what it takes now. A client whose queue overflows is dropped. */
+static void	ft_serve_send(t_server *s, long id, const void *p, size_t n)
+{
+	t_client	*c;
+	int			k;
+
+	k = 0;
+	while (k < SERVER_CLIENTS && s->client[k].id != id)
+		k++;
+	if (k == SERVER_CLIENTS)
+		return ;
+	c = &s->client[k];
+	if (ft_serve_room(c, n) != 0)
+	{
+		ft_serve_drop(c);
+		return ;
+	}
+	ft_memcpy(c->out + c->out_len, p, n);
+	c->out_len += n;
+	ft_serve_flush(c);
+}
+
+static void	ft_serve_error(t_server *s, long id, const char *err)
+{
+	char	line[SERVER_LINE];
+
+	snprintf(line, sizeof(line), "ERR %s\n", err);
+	ft_serve_send(s, id, line, ft_strlen(line));
+}
+
+/* Integer of the request at *p, followed by sep (any character if 0). */
+static int	ft_serve_num(char **p, long long *v, char sep)
+{
+	char	*end;
+
+	*v = strtoll(*p, &end, 10);
+	if (end == *p || (sep && *end != sep))
+		return (1);
+	*p = end + (sep != 0);
+	return (0);
+}
+
+/* Options after the format: the formula of type 9, or cr ci. */
+static const char	*ft_serve_extra(char *p, t_request *r)
+{
+	char	*end;
+
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (r->type == 9)
+	{
+		if (!*p)
+			return ("missing formula");
+		ft_strlcpy(r->formula, p, sizeof(r->formula));
+		return (NULL);
+	}
+	if (!*p)
+		return (NULL);
+	r->custom = 1;
+	r->cr = strtod(p, &end);
+	if (end == p)
+		return ("bad cr ci");
+	p = end;
+	r->ci = strtod(p, &end);
+	if (end == p)
+		return ("bad cr ci");
+	while (*end == ' ' || *end == '\t')
+		end++;
+	if (*end)
+		return ("unexpected text after cr ci");
+	return (NULL);
+}
+
+/* Parses a request line into r. Returns what is wrong with it, NULL if
+ nothing. */
+static const char	*ft_serve_parse(char *p, t_request *r)
+{
+	long long	v[5];
+
+	ft_bzero(r, sizeof(*r));
+	if (ft_serve_num(&p, &v[0], 0) || ft_serve_num(&p, &v[1], 0)
+		|| ft_serve_num(&p, &v[2], '/') || ft_serve_num(&p, &v[3], '/')
+		|| ft_serve_num(&p, &v[4], 0))
+		return ("expected: type iteration z/x/y raw|png [cr ci | formula]");
+	if (v[0] < 1 || v[0] > 9)
+		return ("type out of 1 .. 9");
+	if (v[1] < 1 || v[1] > SERVER_ITER)
+		return ("iteration out of range");
+	if (v[2] < 0 || v[2] > SERVER_ZOOM || v[3] < 0 || v[4] < 0
+		|| v[3] >= (1LL << v[2]) || v[4] >= (1LL << v[2]))
+		return ("tile out of the map");
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if ((ft_strncmp(p, "raw", 3) && ft_strncmp(p, "png", 3))
+		|| (p[3] && p[3] != ' ' && p[3] != '\t'))
+		return ("format is raw or png");
+	r->type = v[0];
+	r->iteration = v[1];
+	r->z = v[2];
+	r->x = v[3];
+	r->y = v[4];
+	r->png = (*p == 'p');
+	return (ft_serve_extra(p + 3, r));
+}
+
+/* Puts the view of tile r in f. Returns why it cannot be rendered, NULL if
+ it can. */
+static const char	*ft_serve_view(t_fractol *f, const t_request *r)
+{
+	char		*av[6];
+	long double	span;
+	long double	c[2];
+	t_big		d;
+
+	ft_bzero(av, sizeof(av));
+	f->fractal.type = r->type;
+	ft_fractol_init(f, av);
+	c[0] = f->fractal.offset_x + DEFAULT_WIDTH / 2.0L / f->fractal.scale - 2;
+	c[1] = f->fractal.offset_y + DEFAULT_HEIGHT / 2.0L / f->fractal.scale - 2;
+	span = ldexpl(4, -r->z);
+	f->fractal.scale = SERVER_TILE / span;
+	if (f->fractal.scale > ft_scale_limit(f))
+		return ("zoom too deep for this type");
+	if (r->type == 9 && ft_formula_compile(&f->formula, r->formula) != 0)
+		return ("bad formula");
+	ft_big_from_ld(&f->fractal.center[0], c[0], BIG_LIMBS);
+	ft_big_from_ld(&d, (r->x + 0.5L) * span, BIG_LIMBS);
+	ft_big_add(&f->fractal.center[0], &f->fractal.center[0], &d);
+	ft_big_from_ld(&f->fractal.center[1], c[1], BIG_LIMBS);
+	ft_big_from_ld(&d, (r->y + 0.5L) * span, BIG_LIMBS);
+	ft_big_add(&f->fractal.center[1], &f->fractal.center[1], &d);
+	f->fractal.iteration = r->iteration;
+	f->fractal.custom_c = r->custom;
+	f->fractal.cr = r->cr;
+	f->fractal.ci = r->ci;
+	ft_view_move(f, 0, 0);
+	return (NULL);
+}
+
+/* Renders the tile of job j and answers every client waiting for it. */
+static void	ft_serve_job(t_server *s, t_fractol *f, const t_job *j)
+{
+	const char		*err;
+	unsigned char	*data;
+	size_t			size;
+	char			head[SERVER_LINE];
+	int				k;
+
+	data = NULL;
+	err = ft_serve_view(f, &j->req);
+	if (!err)
+	{
+		ft_render_image(f);
+		size = sizeof(float) * SERVER_TILE * SERVER_TILE;
+		data = (unsigned char *)f->render.values;
+		if (j->req.png)
+			data = ft_png_encode(f, &size);
+		if (!data)
+			err = "out of memory";
+	}
+	if (!err)
+		snprintf(head, sizeof(head), "OK %d/%lld/%lld %zu\n", j->req.z,
+			(long long)j->req.x, (long long)j->req.y, size);
+	k = -1;
+	while (++k < j->count)
+	{
+		if (err)
+			ft_serve_error(s, j->waiter[k], err);
+		else
+		{
+			ft_serve_send(s, j->waiter[k], head, ft_strlen(head));
+			ft_serve_send(s, j->waiter[k], data, size);
+		}
+	}
+	if (j->req.png)
+		free(data);
+}
+
+/* Adds request r of client id to the batch: to the job of the same tile
+ if there is one, else as a new job. */
+static void	ft_serve_queue(t_server *s, const t_request *r, long id)
+{
+	t_job	*j;
+	int		k;
+
+	k = 0;
+	while (k < s->jobs && (s->job[k].count == SERVER_CLIENTS
+			|| ft_memcmp(&s->job[k].req, r, sizeof(*r)) != 0))
+		k++;
+	j = &s->job[k];
+	if (k == s->jobs)
+	{
+		j->req = *r;
+		j->count = 0;
+		s->jobs++;
+	}
+	j->waiter[j->count++] = id;
+}
+
+/* Queues the complete request lines of client c while the batch has room.
+ A line longer than SERVER_LINE drops the client. */
+static void	ft_serve_lines(t_server *s, t_client *c)
+{
+	t_request	r;
+	const char	*err;
+	char		*nl;
+
+	nl = ft_memchr(c->line, '\n', c->len);
+	while (c->fd >= 0 && nl && s->jobs < SERVER_BATCH)
+	{
+		*nl = '\0';
+		if (nl > c->line && nl[-1] == '\r')
+			nl[-1] = '\0';
+		err = ft_serve_parse(c->line, &r);
+		if (err)
+			ft_serve_error(s, c->id, err);
+		else
+			ft_serve_queue(s, &r, c->id);
+		c->len -= nl + 1 - c->line;
+		ft_memmove(c->line, nl + 1, c->len);
+		nl = ft_memchr(c->line, '\n', c->len);
+	}
+	if (c->fd < 0 || nl || c->len < SERVER_LINE)
+		return ;
+	ft_serve_error(s, c->id, "line too long");
+	if (c->fd >= 0)
+		ft_serve_drop(c);
+}
+
+/* New connection into a free client slot; refused when there is none. */
+static void	ft_serve_accept(t_server *s)
+{
+	int	fd;
+	int	k;
+
+	fd = accept(s->fd, NULL, NULL);
+	if (fd < 0)
+		return ;
+	k = 0;
+	while (k < SERVER_CLIENTS && s->client[k].fd >= 0)
+		k++;
+	if (k == SERVER_CLIENTS)
+	{
+		send(fd, "ERR too many clients\n", 21, MSG_NOSIGNAL);
+		close(fd);
+		return ;
+	}
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	s->client[k].fd = fd;
+	s->client[k].id = ++s->ids;
+	s->client[k].len = 0;
+}
+
+/* Reads from client c, or drops it when it hung up. */
+static void	ft_serve_read(t_client *c)
+{
+	ssize_t	n;
+
+	n = read(c->fd, c->line + c->len, SERVER_LINE - c->len);
+	if (n > 0)
+		c->len += n;
+	else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+		ft_serve_drop(c);
+}
+
+/* Waits for requests (not at all if lines are already waiting) or room
+ for queued answers, then sends, accepts, reads and fills the batch. */
+static void	ft_serve_poll(t_server *s)
+{
+	struct pollfd	fds[SERVER_CLIENTS + 1];
+	int				wait;
+	int				k;
+
+	wait = -1;
+	fds[0].fd = s->fd;
+	fds[0].events = POLLIN;
+	k = -1;
+	while (++k < SERVER_CLIENTS)
+	{
+		fds[k + 1].fd = s->client[k].fd;
+		fds[k + 1].events = POLLIN;
+		if (s->client[k].out_len)
+			fds[k + 1].events |= POLLOUT;
+		fds[k + 1].revents = 0;
+		if (s->client[k].fd >= 0
+			&& ft_memchr(s->client[k].line, '\n', s->client[k].len))
+			wait = 0;
+	}
+	if (poll(fds, SERVER_CLIENTS + 1, wait) < 0)
+		return ;
+	k = -1;
+	while (++k < SERVER_CLIENTS)
+	{
+		if (s->client[k].fd >= 0 && (fds[k + 1].revents & POLLOUT))
+			ft_serve_flush(&s->client[k]);
+		if (s->client[k].fd >= 0 && s->client[k].len < SERVER_LINE
+			&& (fds[k + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+			ft_serve_read(&s->client[k]);
+		if (s->client[k].fd >= 0)
+			ft_serve_lines(s, &s->client[k]);
+	}
+	if (fds[0].revents & POLLIN)
+		ft_serve_accept(s);
+}
+
+/* Headless frame of one tile: image and buffers without MiniLibX. */
+static int	ft_serve_init(t_fractol *f)
+{
+	size_t	n;
+
+	ft_bzero(f, sizeof(*f));
+	n = SERVER_TILE * SERVER_TILE;
+	f->mlx.width = SERVER_TILE;
+	f->mlx.height = SERVER_TILE;
+	f->mlx.bits_per_pixel = 32;
+	f->mlx.line_length = 4 * SERVER_TILE;
+	f->mlx.addr = malloc(4 * n);
+	f->render.values = malloc(sizeof(float) * n);
+	f->render.dist = malloc(sizeof(float) * n);
+	f->render.glitch = malloc(n);
+	if (!f->mlx.addr || !f->render.values || !f->render.dist
+		|| !f->render.glitch)
+		return (1);
+	return (ft_pool_init(&f->pool));
+}
+
+/* Server mode: serves tiles on the Unix socket at path until killed. */
+int	ft_serve(const char *path)
+{
+	t_fractol	f;
+	t_server	s;
+	int			k;
+
+	if (!path)
+	{
+		ft_putstr_fd("Error: missing socket path, ./fractol serve <path>\n", 2);
+		return (1);
+	}
+	ft_bzero(&s, sizeof(s));
+	s.fd = -1;
+	if (ft_serve_init(&f) == 0)
+		s.fd = ft_serve_listen(path);
+	if (s.fd < 0)
+	{
+		ft_putstr_fd("Error: cannot start the tile server\n", 2);
+		free(f.mlx.addr);
+		clean_exit(&f, 1);
+	}
+	k = -1;
+	while (++k < SERVER_CLIENTS)
+		s.client[k].fd = -1;
+	printf("Serving %dx%d tiles on %s\n", SERVER_TILE, SERVER_TILE, path);
+	fflush(stdout);
+	while (1)
+	{
+		ft_serve_poll(&s);
+		k = -1;
+		while (++k < s.jobs)
+			ft_serve_job(&s, &f, &s.job[k]);
+		s.jobs = 0;
+	}
+}
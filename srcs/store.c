@@ -0,0 +1,257 @@
+#include "../includes/fractol.h"
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * STORE DI TILE - La cache di tile (tiles.c) muore con il processo; le
+ * stesse zone famose pero' si rivisitano a ogni avvio. Le tile finite
+ * vanno quindi anche in un file, $XDG_CACHE_HOME/fractol/tiles-... (o
+ * ~/.cache/fractol/tiles-...), mappato in memoria e condiviso da tutti i
+ * processi:
+ *
+ * - il file ha dimensione fissa, sparso: un header con STORE_GRIDS griglie
+ *   e STORE_SLOTS slot di tile, poi i dati delle tile allineati alla
+ *   pagina. Lo spazio su disco e' solo quello delle tile scritte
+ * - il nome porta TILE_SIZE, STORE_SLOTS e la lunghezza, quindi build con
+ *   un altro layout usano un altro file: un file mappato da altri processi
+ *   non si accorcia mai, chi legge oltre la nuova fine prenderebbe SIGBUS
+ * - le griglie sono quelle di tiles.c, con l'origine esatta: una griglia
+ *   nuova in memoria si allinea a una del file con gli stessi parametri e
+ *   la stessa scala se i pixel del frame cadono sui suoi, cosi' un
+ *   processo nuovo ritrova le tile di quelli vecchi. La chiave della
+ *   griglia nel file e' un contatore del file
+ * - una tile sta in uno dei STORE_PROBE slot dopo l'hash di (griglia, x,
+ *   y); quando sono tutti pieni esce quello scritto meno di recente
+ * - la lettura copia i dati dalla mappa direttamente nel frame, senza
+ *   chiamate di sistema ne' buffer. Non prende lock: ogni slot ha un
+ *   contatore di sequenza, dispari mentre qualcuno lo scrive, e la copia
+ *   vale solo se il contatore e' pari e uguale prima e dopo
+ * - le scritture (nuove griglie, tile di un frame finito) tengono il lock
+ *   esclusivo del file (flock), una alla volta tra i processi
+ *
+ * I valori restano float non compressi: la lettura e' una memcpy dalla
+ * page cache, piu' veloce di qualsiasi decompressione. Il kernel conta
+ * nei parametri per la sua voce del registro (tipo, potenza, precisione),
+ * non per il suo indirizzo, quindi il file vale tra build e macchine
+ * diverse; STORE_VERSION e le tolleranze dei kernel profondi sono nello
+ * stesso hash. Se il file non si apre resta la sola cache in memoria.
+ */
+
+static size_t	ft_store_head_size(void)
+{
+	return ((sizeof(t_store_head) + 4095) & ~(size_t)4095);
+}
+
+static float	*ft_store_data(t_store *s, int k)
+{
+	return (s->data + (size_t)k * 2 * TILE_SIZE * TILE_SIZE);
+}
+
+static int	ft_store_hash(uint64_t key, const int64_t *g)
+{
+	uint64_t	h;
+
+	h = key * 0x9E3779B97F4A7C15ULL;
+	h ^= (uint64_t)g[0] * 0xC2B2AE3D27D4EB4FULL;
+	h ^= (uint64_t)g[1] * 0x165667B19E3779F9ULL;
+	return ((int)((h ^ (h >> 29)) % STORE_SLOTS));
+}
+
+/* Maps the store file, grown to its length when new. It is never shrunk:
+ other processes may have it mapped and would fault past the new end. On
+ failure map stays NULL. */
+static int	ft_store_map(t_store *s)
+{
+	struct stat	st;
+
+	if (fstat(s->fd, &st) != 0)
+		return (1);
+	if ((size_t)st.st_size < s->length && ftruncate(s->fd, s->length) != 0)
+		return (1);
+	s->map = mmap(NULL, s->length, PROT_READ | PROT_WRITE, MAP_SHARED,
+			s->fd, 0);
+	if (s->map == MAP_FAILED)
+	{
+		s->map = NULL;
+		return (1);
+	}
+	if (s->map->magic != STORE_MAGIC || s->map->size != sizeof(t_store_head))
+	{
+		ft_bzero(s->map, sizeof(t_store_head));
+		s->map->magic = STORE_MAGIC;
+		s->map->size = sizeof(t_store_head);
+	}
+	s->data = (float *)((char *)s->map + ft_store_head_size());
+	return (0);
+}
+
+/* Opens the store on first use, once per process. */
+void	ft_store_open(t_store *s)
+{
+	char	dir[JIT_PATH];
+	char	path[JIT_PATH];
+	int		err;
+
+	if (s->opened)
+		return ;
+	s->opened = 1;
+	s->map = NULL;
+	s->length = ft_store_head_size() + sizeof(float) * 2 * TILE_SIZE
+		* TILE_SIZE * (size_t)STORE_SLOTS;
+	s->fd = -1;
+	if (ft_cache_dir(dir, sizeof(dir)) != 0
+		|| snprintf(path, sizeof(path), "%s/tiles-%d-%d-%zx", dir, TILE_SIZE,
+			STORE_SLOTS, s->length) >= (int)sizeof(path))
+		return ;
+	s->fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (s->fd < 0)
+		return ;
+	err = (flock(s->fd, LOCK_EX) != 0 || ft_store_map(s) != 0);
+	flock(s->fd, LOCK_UN);
+	if (!err)
+		return ;
+	close(s->fd);
+	s->fd = -1;
+}
+
+/* Lines the new grid g up with a grid of the store of the same params and
+ scale that the frame pixels (c0 the first) fall on, or adds g to the
+ store. Sets g->key, and tiles.ox, tiles.oy when it moves the origin. */
+void	ft_store_grid(t_fractol *f, t_grid *g, const t_big *c0)
+{
+	t_store_head	*h;
+	t_store_grid	*e;
+	int				best;
+	int				k;
+
+	h = f->tiles.store.map;
+	if (!h || flock(f->tiles.store.fd, LOCK_EX) != 0)
+		return ;
+	best = 0;
+	k = -1;
+	while (++k < STORE_GRIDS)
+	{
+		e = &h->grid[k];
+		if (e->key && e->params == g->params
+			&& fabsl(g->scale / e->scale - 1) < 1e-12
+			&& ft_tiles_offset(f, c0, e->origin) == 0)
+			break ;
+		if (h->grid[k].stamp < h->grid[best].stamp)
+			best = k;
+	}
+	if (k == STORE_GRIDS)
+	{
+		e = &h->grid[best];
+		e->key = ++h->ids;
+		e->params = g->params;
+		e->scale = g->scale;
+		e->origin[0] = g->origin[0];
+		e->origin[1] = g->origin[1];
+	}
+	g->origin[0] = e->origin[0];
+	g->origin[1] = e->origin[1];
+	g->key = e->key;
+	e->stamp = ++h->clock;
+	flock(f->tiles.store.fd, LOCK_UN);
+}
+
+/* Copies tile g of grid key from the store into the frame, p its first
+ pixel there. Returns 1 on a hit, 0 if missing or rewritten meanwhile. */
+int	ft_store_load(t_fractol *f, uint64_t key, const int64_t *g, const int *p)
+{
+	t_store			*s;
+	t_store_slot	*e;
+	uint32_t		seq;
+	int				k;
+	int				i;
+
+	s = &f->tiles.store;
+	if (!s->map || !key)
+		return (0);
+	k = ft_store_hash(key, g);
+	i = -1;
+	while (++i < STORE_PROBE)
+	{
+		e = &s->map->slot[(k + i) % STORE_SLOTS];
+		seq = __atomic_load_n(&e->seq, __ATOMIC_ACQUIRE);
+		if ((seq & 1) || e->grid != key || e->x != g[0] || e->y != g[1]
+			|| (f->frame.de && !e->de))
+			continue ;
+		ft_tiles_copy(f, ft_store_data(s, (k + i) % STORE_SLOTS), p, 0);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) == seq)
+			return (1);
+	}
+	return (0);
+}
+
+/* Takes the file lock for the ft_store_save calls of a frame. */
+void	ft_store_begin(t_store *s)
+{
+	s->locked = (s->map && flock(s->fd, LOCK_EX) == 0);
+	if (s->locked)
+		s->map->clock++;
+}
+
+/* Writes tile g of grid key, data as the cache holds it, over the same
+ tile or the oldest of its slots. The data go with pwrite: through the
+ mapping every new page of the file would fault. */
+void	ft_store_save(t_fractol *f, uint64_t key, const int64_t *g,
+			const float *data)
+{
+	t_store			*s;
+	t_store_slot	*e;
+	int				best;
+	int				k;
+	int				i;
+
+	s = &f->tiles.store;
+	if (!s->locked || !key)
+		return ;
+	k = ft_store_hash(key, g);
+	best = k;
+	i = -1;
+	while (++i < STORE_PROBE)
+	{
+		e = &s->map->slot[(k + i) % STORE_SLOTS];
+		if (e->grid == key && e->x == g[0] && e->y == g[1])
+		{
+			best = (k + i) % STORE_SLOTS;
+			break ;
+		}
+		if (e->stamp < s->map->slot[best].stamp)
+			best = (k + i) % STORE_SLOTS;
+	}
+	e = &s->map->slot[best];
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	e->grid = key;
+	e->x = g[0];
+	e->y = g[1];
+	e->de = f->frame.de;
+	e->stamp = s->map->clock;
+	if (pwrite(s->fd, data, sizeof(float) * 2 * TILE_SIZE * TILE_SIZE,
+			(char *)ft_store_data(s, best) - (char *)s->map)
+		!= (ssize_t)(sizeof(float) * 2 * TILE_SIZE * TILE_SIZE))
+		e->grid = 0;
+	__atomic_store_n(&e->seq, e->seq + 1, __ATOMIC_RELEASE);
+}
+
+void	ft_store_end(t_store *s)
+{
+	if (s->locked)
+		flock(s->fd, LOCK_UN);
+	s->locked = 0;
+}
+
+void	ft_store_close(t_store *s)
+{
+	if (s->map)
+		munmap(s->map, s->length);
+	if (s->opened && s->fd >= 0)
+		close(s->fd);
+	s->map = NULL;
+	s->opened = 0;
+}
@@ -0,0 +1,124 @@
+#include "../includes/fractol.h"
+
+/*
+ * Pool di thread persistente. I worker dormono su una condition variable;
+ * ft_pool_run pubblica un lavoro (una funzione e un numero di indici) e gli
+ * indici vengono distribuiti con un contatore atomico, cosi' i thread piu'
+ * veloci prendono piu' righe. Anche il thread chiamante lavora: il suo
+ * id e' pool->count, gli altri vanno da 0 a pool->count - 1.
+ */
+static void	ft_pool_work(t_pool *pool, int thread)
+{
+	int	index;
+
+	index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+	while (index < pool->jobs)
+	{
+		pool->job(pool->arg, index, thread);
+		index = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+	}
+}
+
+static void	*ft_pool_worker(void *param)
+{
+	t_worker		*worker;
+	t_pool			*pool;
+	unsigned long	seen;
+
+	worker = param;
+	pool = worker->pool;
+	seen = 0;
+	while (1)
+	{
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->quit && pool->batch == seen)
+			pthread_cond_wait(&pool->start, &pool->lock);
+		seen = pool->batch;
+		pthread_mutex_unlock(&pool->lock);
+		if (pool->quit)
+			break ;
+		ft_pool_work(pool, worker->id);
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->busy == 0)
+			pthread_cond_signal(&pool->done);
+		pthread_mutex_unlock(&pool->lock);
+	}
+	return (NULL);
+}
+
+/* Starts one worker per online CPU minus the calling thread.
+ @return 0 in caso di successo, 1 in caso di errore */
+int	ft_pool_init(t_pool *pool)
+{
+	long	cpus;
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus < 1)
+		cpus = 1;
+	if (cpus > MAX_THREADS)
+		cpus = MAX_THREADS;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	pool->workers = ft_calloc(cpus, sizeof(t_worker));
+	if (!pool->workers)
+		return (1);
+	pool->count = 0;
+	while (pool->count < cpus - 1)
+	{
+		pool->workers[pool->count].pool = pool;
+		pool->workers[pool->count].id = pool->count;
+		if (pthread_create(&pool->workers[pool->count].thread, NULL,
+				ft_pool_worker, &pool->workers[pool->count]) != 0)
+			break ;
+		pool->count++;
+	}
+	return (0);
+}
+
+/* Runs job(arg, index, thread) for every index in [0, jobs) on the pool
+ and returns once all of them are done. */
+void	ft_pool_run(t_pool *pool, void (*job)(void *, int, int), void *arg,
+		int jobs)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->job = job;
+	pool->arg = arg;
+	pool->jobs = jobs;
+	pool->next = 0;
+	pool->busy = pool->count;
+	pool->batch++;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+	ft_pool_work(pool, pool->count);
+	pthread_mutex_lock(&pool->lock);
+	while (pool->busy > 0)
+		pthread_cond_wait(&pool->done, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/* Number of distinct thread ids a job can see (workers + caller). */
+int	ft_pool_size(t_pool *pool)
+{
+	return (pool->count + 1);
+}
+
+void	ft_pool_destroy(t_pool *pool)
+{
+	int	i;
+
+	if (!pool->workers)
+		return ;
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = 1;
+	pthread_cond_broadcast(&pool->start);
+	pthread_mutex_unlock(&pool->lock);
+	i = -1;
+	while (++i < pool->count)
+		pthread_join(pool->workers[i].thread, NULL);
+	free(pool->workers);
+	pool->workers = NULL;
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->start);
+	pthread_cond_destroy(&pool->done);
+}
@@ -0,0 +1,434 @@
+#include "../includes/fractol.h"
+#include "../includes/floatexp.h"
+
+/*
+ * CACHE DI TILE - Tornando indietro con la rotella (o ridisegnando per un
+ * cambio di palette) si ricalcolano zone gia' viste alla stessa scala.
+ * I valori di fuga dei frame finiti restano in una cache di tile da
+ * TILE_SIZE pixel, al massimo TILE_MEMORY byte, la meno usata di recente
+ * esce per prima:
+ *
+ * - le tile stanno su una griglia (t_grid) per ogni scala: l'origine e' il
+ *   pixel (0, 0) del primo frame a quella scala, esatta in t_big. Un frame
+ *   alla stessa scala la usa se i suoi pixel cadono sui pixel della
+ *   griglia, entro TILE_SNAP: e' il caso di pan con le frecce (pixel
+ *   interi) e di zoom avanti e indietro con il mouse fermo, che riportano
+ *   centro e scala dove erano. Altrimenti il frame apre una griglia nuova
+ * - la chiave di una tile e' (griglia, x, y); la griglia porta con se'
+ *   l'hash di quanto decide i valori (kernel, iterazioni, bailout, c della
+ *   Julia, formula, smooth, DE, trappola): se uno cambia non c'e' griglia
+ * - all'inizio del frame le tile trovate vengono copiate in render.values
+ *   (e dist), e le righe calcolano solo i tratti fuori da esse; finito il
+ *   frame, correzione dei glitch compresa, si salvano le tile intere che
+ *   mancavano
+ * - le tile che mancano in memoria si cercano poi nello store su disco
+ *   (store.c), dove finiscono anche quelle salvate, per i prossimi avvii
+ *
+ * Le zoomate hanno passo SCALE_PRS e non 2, quindi i livelli non formano
+ * un quadtree: ogni scala ha la sua griglia e si riusano solo tile della
+ * stessa scala.
+ */
+
+static int64_t	ft_floor_div(int64_t a, int64_t b)
+{
+	return (a / b - (a % b != 0 && (a < 0) != (b < 0)));
+}
+
+/* FNV-1a over n bytes. */
+static uint64_t	ft_tiles_mix(uint64_t h, const void *p, size_t n)
+{
+	const unsigned char	*b;
+
+	b = p;
+	while (n--)
+		h = (h ^ *b++) * 1099511628211ULL;
+	return (h);
+}
+
+/* Kernel of the frame as its registry entry (type, power, precision), the
+ precision it falls back to included, plus 1 for the JIT one: the same key
+ in every build and on every machine. */
+static uint64_t	ft_tiles_kernel(t_fractol *f, uint64_t h)
+{
+	const t_kernel_entry	*entry;
+	int						key[4];
+
+	entry = ft_kernel_lookup(f->fractal.type, f->fractal.power,
+			f->frame.precision);
+	key[0] = entry->type;
+	key[1] = entry->power;
+	key[2] = entry->precision;
+	if (key[2] == PREC_PERTURB && !f->frame.orbit)
+		key[2] = PREC_DOUBLE;
+	key[3] = (f->frame.kernel == f->jit.kernel);
+	return (ft_tiles_mix(h, key, sizeof(key)));
+}
+
+/* Hash of everything the escape values of a pixel depend on, its
+ coordinates apart: the kernel, the view and the tolerances of the deep
+ kernels. STORE_VERSION goes up when a kernel changes its values. */
+static uint64_t	ft_tiles_params(t_fractol *f)
+{
+	static const double	constants[] = {STORE_VERSION, SMOOTH_BAILOUT,
+		SA_TERMS, SA_TOLERANCE, BLA_EPSILON, GLITCH_TOLERANCE, GLITCH_TILE,
+		GLITCH_REFS, GLITCH_ROUNDS, GLITCH_REUSE, FEXP_SWITCH};
+	const t_frame		*fr;
+	uint64_t			h;
+
+	fr = &f->frame;
+	h = ft_tiles_mix(14695981039346656037ULL, constants, sizeof(constants));
+	h = ft_tiles_kernel(f, h);
+	h = ft_tiles_mix(h, &fr->jr, sizeof(fr->jr));
+	h = ft_tiles_mix(h, &fr->ji, sizeof(fr->ji));
+	h = ft_tiles_mix(h, &fr->bailout, sizeof(fr->bailout));
+	h = ft_tiles_mix(h, &fr->log2_power, sizeof(fr->log2_power));
+	h = ft_tiles_mix(h, &fr->iteration, sizeof(fr->iteration));
+	h = ft_tiles_mix(h, &fr->smooth, sizeof(fr->smooth));
+	h = ft_tiles_mix(h, &fr->de, sizeof(fr->de));
+	h = ft_tiles_mix(h, &fr->trap, sizeof(fr->trap));
+	h = ft_tiles_mix(h, fr->trap_off, sizeof(fr->trap_off));
+	if (f->fractal.type == 9)
+		h = ft_tiles_mix(h, f->formula.code,
+				sizeof(t_insn) * f->formula.count);
+	return (h);
+}
+
+/* Cache memory on first use. Returns 1 without it. */
+static int	ft_tiles_alloc(t_tiles *t)
+{
+	int	k;
+
+	if (t->cap)
+		return (0);
+	k = TILE_MEMORY / (2 * TILE_SIZE * TILE_SIZE * sizeof(float));
+	t->tile = malloc(sizeof(t_cached) * k);
+	t->bucket = malloc(sizeof(int) * k);
+	t->data = malloc(sizeof(float) * 2 * TILE_SIZE * TILE_SIZE * k);
+	if (!t->tile || !t->bucket || !t->data)
+	{
+		free(t->tile);
+		free(t->bucket);
+		free(t->data);
+		t->tile = NULL;
+		t->bucket = NULL;
+		t->data = NULL;
+		return (1);
+	}
+	t->cap = k;
+	while (k--)
+		t->bucket[k] = -1;
+	t->head = -1;
+	t->tail = -1;
+	return (0);
+}
+
+/* Grid pixel of frame pixel (0, 0), c0, on the grid of pixel (0, 0)
+ origin at the frame scale, in tiles.ox, tiles.oy. Returns 1 if the frame
+ pixels fall between those of the grid. */
+int	ft_tiles_offset(t_fractol *f, const t_big *c0, const t_big *origin)
+{
+	t_big	d;
+	t_fexp	scale;
+	double	off[2];
+	int		e;
+	int		k;
+
+	scale.m = frexpl(f->fractal.scale, &e);
+	scale.e = e;
+	k = -1;
+	while (++k < 2)
+	{
+		ft_big_sub(&d, &c0[k], &origin[k]);
+		off[k] = fe_to_d(fe_mul(ft_big_to_fexp(&d), scale));
+		if (!(fabs(off[k]) < 1e15 && fabs(off[k] - round(off[k])) < TILE_SNAP))
+			return (1);
+	}
+	f->tiles.ox = llround(off[0]);
+	f->tiles.oy = llround(off[1]);
+	return (0);
+}
+
+/* Slot of the grid the frame lands on, a new grid in the least recently
+ used slot if none, lined up with a grid of the store if one fits. */
+static int	ft_tiles_grid(t_fractol *f, uint64_t params)
+{
+	t_tiles	*t;
+	t_big	c0[2];
+	t_big	d;
+	int		best;
+	int		k;
+
+	t = &f->tiles;
+	ft_big_from_ld(&d, f->mlx.width / 2.0L / f->fractal.scale, BIG_LIMBS);
+	ft_big_sub(&c0[0], &f->fractal.center[0], &d);
+	ft_big_from_ld(&d, f->mlx.height / 2.0L / f->fractal.scale, BIG_LIMBS);
+	ft_big_sub(&c0[1], &f->fractal.center[1], &d);
+	best = 0;
+	k = -1;
+	while (++k < TILE_GRIDS)
+	{
+		if (t->grid[k].id && t->grid[k].params == params
+			&& fabsl(f->fractal.scale / t->grid[k].scale - 1) < 1e-12
+			&& ft_tiles_offset(f, c0, t->grid[k].origin) == 0)
+			return (k);
+		if (t->grid[k].used < t->grid[best].used)
+			best = k;
+	}
+	t->grid[best].id = ++t->ids;
+	t->grid[best].params = params;
+	t->grid[best].scale = f->fractal.scale;
+	t->grid[best].origin[0] = c0[0];
+	t->grid[best].origin[1] = c0[1];
+	t->grid[best].key = 0;
+	t->ox = 0;
+	t->oy = 0;
+	ft_store_grid(f, &t->grid[best], c0);
+	return (best);
+}
+
+static int	ft_tiles_hash(const t_tiles *t, int grid, int64_t x, int64_t y)
+{
+	uint64_t	h;
+
+	h = (uint64_t)grid * 0x9E3779B97F4A7C15ULL;
+	h ^= (uint64_t)x * 0xC2B2AE3D27D4EB4FULL;
+	h ^= (uint64_t)y * 0x165667B19E3779F9ULL;
+	return ((int)((h ^ (h >> 29)) % (uint64_t)t->cap));
+}
+
+/* Moves tile k to the head of the recently used list, or puts it there
+ when k is not in it (unlink 0). */
+static void	ft_tiles_touch(t_tiles *t, int k, int unlink)
+{
+	if (unlink)
+	{
+		if (t->head == k)
+			return ;
+		t->tile[t->tile[k].prev].next = t->tile[k].next;
+		if (t->tile[k].next >= 0)
+			t->tile[t->tile[k].next].prev = t->tile[k].prev;
+		else
+			t->tail = t->tile[k].prev;
+	}
+	t->tile[k].prev = -1;
+	t->tile[k].next = t->head;
+	if (t->head >= 0)
+		t->tile[t->head].prev = k;
+	t->head = k;
+	if (t->tail < 0)
+		t->tail = k;
+}
+
+static int	ft_tiles_find(t_tiles *t, int grid, int64_t x, int64_t y)
+{
+	int	k;
+
+	k = t->bucket[ft_tiles_hash(t, grid, x, y)];
+	while (k >= 0 && (t->tile[k].grid != grid || t->tile[k].x != x
+			|| t->tile[k].y != y))
+		k = t->tile[k].chain;
+	return (k);
+}
+
+/* Copies a tile between data (values then distances) and the frame
+ buffers, the part of it inside the frame; p is its first pixel in the
+ frame. */
+void	ft_tiles_copy(t_fractol *f, float *data, const int *p, int save)
+{
+	size_t	at;
+	int		x[2];
+	int		y;
+
+	x[0] = (p[0] < 0) * -p[0];
+	x[1] = f->mlx.width - p[0];
+	if (x[1] > TILE_SIZE)
+		x[1] = TILE_SIZE;
+	y = (p[1] < 0) * -p[1] - 1;
+	while (++y < TILE_SIZE && p[1] + y < f->mlx.height)
+	{
+		at = (size_t)(p[1] + y) * f->mlx.width + p[0];
+		if (save)
+			ft_memcpy(data + y * TILE_SIZE + x[0], f->render.values + at
+				+ x[0], sizeof(float) * (x[1] - x[0]));
+		else
+			ft_memcpy(f->render.values + at + x[0], data + y * TILE_SIZE
+				+ x[0], sizeof(float) * (x[1] - x[0]));
+		if (f->frame.de && save)
+			ft_memcpy(data + (TILE_SIZE + y) * TILE_SIZE + x[0],
+				f->render.dist + at + x[0], sizeof(float) * (x[1] - x[0]));
+		else if (f->frame.de)
+			ft_memcpy(f->render.dist + at + x[0], data + (TILE_SIZE + y)
+				* TILE_SIZE + x[0], sizeof(float) * (x[1] - x[0]));
+		if (!save && f->frame.orbit)
+			ft_bzero(f->render.glitch + at + x[0], x[1] - x[0]);
+	}
+}
+
+static float	*ft_tiles_data(t_tiles *t, int k)
+{
+	return (t->data + (size_t)k * 2 * TILE_SIZE * TILE_SIZE);
+}
+
+/* Grid tile g and its first pixel p in the frame, for tile k of the
+ frame counted in rows of t->tx. */
+static void	ft_tiles_at(const t_tiles *t, int k, int64_t *g, int *p)
+{
+	g[0] = ft_floor_div(t->ox, TILE_SIZE) + k % t->tx;
+	g[1] = ft_floor_div(t->oy, TILE_SIZE) + k / t->tx;
+	p[0] = g[0] * TILE_SIZE - t->ox;
+	p[1] = g[1] * TILE_SIZE - t->oy;
+}
+
+/* Frame start, after ft_frame_setup: picks the grid and copies the tiles
+ of the frame found in the cache, or else in the store. */
+void	ft_tiles_begin(t_fractol *f)
+{
+	t_tiles	*t;
+	int64_t	g[2];
+	int		p[2];
+	int		k;
+	int		n;
+
+	t = &f->tiles;
+	t->cur = -1;
+	t->stored = 0;
+	if (ft_tiles_alloc(t) != 0)
+		return ;
+	ft_store_open(&t->store);
+	t->cur = ft_tiles_grid(f, ft_tiles_params(f));
+	t->grid[t->cur].used = ++t->clock;
+	t->tx = ft_floor_div(t->ox + f->mlx.width - 1, TILE_SIZE)
+		- ft_floor_div(t->ox, TILE_SIZE) + 1;
+	t->ty = ft_floor_div(t->oy + f->mlx.height - 1, TILE_SIZE)
+		- ft_floor_div(t->oy, TILE_SIZE) + 1;
+	if (t->tx * t->ty > t->hit_cap)
+	{
+		free(t->hit);
+		t->hit = malloc(t->tx * t->ty);
+		t->hit_cap = t->tx * t->ty * (t->hit != NULL);
+		if (!t->hit)
+			t->cur = -1;
+	}
+	k = -1;
+	while (t->cur >= 0 && ++k < t->tx * t->ty)
+	{
+		ft_tiles_at(t, k, g, p);
+		n = ft_tiles_find(t, t->grid[t->cur].id, g[0], g[1]);
+		t->hit[k] = (n >= 0);
+		if (n < 0)
+		{
+			t->hit[k] = ft_store_load(f, t->grid[t->cur].key, g, p);
+			continue ;
+		}
+		ft_tiles_touch(t, n, 1);
+		ft_tiles_copy(f, ft_tiles_data(t, n), p, 0);
+	}
+}
+
+/* Row y of the frame into row (count, out, dist and glitch set for the
+ whole row): only the spans outside the tiles copied from the cache. */
+void	ft_tiles_row(t_fractol *f, int y, t_row *row)
+{
+	t_tiles			*t;
+	t_row			span;
+	unsigned char	*hit;
+	int				x[2];
+	int				k;
+
+	t = &f->tiles;
+	if (t->cur < 0)
+	{
+		ft_frame_row(&f->frame, 0, y, row);
+		return ;
+	}
+	hit = t->hit + (ft_floor_div(t->oy + y, TILE_SIZE)
+			- ft_floor_div(t->oy, TILE_SIZE)) * t->tx;
+	span = *row;
+	k = 0;
+	while (k < t->tx)
+	{
+		x[0] = (ft_floor_div(t->ox, TILE_SIZE) + k) * TILE_SIZE - t->ox;
+		while (k < t->tx && !hit[k])
+			k++;
+		x[1] = (ft_floor_div(t->ox, TILE_SIZE) + k) * TILE_SIZE - t->ox;
+		x[0] *= (x[0] > 0);
+		if (x[1] > row->count)
+			x[1] = row->count;
+		span.count = x[1] - x[0];
+		span.out = row->out + x[0];
+		span.dist = row->dist ? row->dist + x[0] : NULL;
+		span.glitch = row->glitch ? row->glitch + x[0] : NULL;
+		if (span.count > 0)
+			ft_frame_row(&f->frame, x[0], y, &span);
+		k++;
+	}
+}
+
+/* Takes the slot of a new tile: a free one or the least recently used,
+ out of its hash chain. */
+static int	ft_tiles_take(t_tiles *t)
+{
+	int	*link;
+	int	k;
+
+	if (t->count < t->cap)
+		return (t->count++);
+	k = t->tail;
+	link = &t->bucket[ft_tiles_hash(t, t->tile[k].grid, t->tile[k].x,
+			t->tile[k].y)];
+	while (*link != k)
+		link = &t->tile[*link].chain;
+	*link = t->tile[k].chain;
+	t->tail = t->tile[k].prev;
+	if (t->tail >= 0)
+		t->tile[t->tail].next = -1;
+	else
+		t->head = -1;
+	return (k);
+}
+
+/* Finished frame, glitches corrected: saves the whole tiles of it that
+ did not come from the cache or the store to both. */
+void	ft_tiles_store(t_fractol *f)
+{
+	t_tiles	*t;
+	int64_t	g[2];
+	int		p[2];
+	int		h;
+	int		k;
+	int		n;
+
+	t = &f->tiles;
+	if (t->cur < 0 || t->stored)
+		return ;
+	t->stored = 1;
+	ft_store_begin(&t->store);
+	k = -1;
+	while (++k < t->tx * t->ty)
+	{
+		ft_tiles_at(t, k, g, p);
+		if (t->hit[k] || p[0] < 0 || p[1] < 0 || p[0] + TILE_SIZE
+			> f->mlx.width || p[1] + TILE_SIZE > f->mlx.height)
+			continue ;
+		n = ft_tiles_take(t);
+		t->tile[n].grid = t->grid[t->cur].id;
+		t->tile[n].x = g[0];
+		t->tile[n].y = g[1];
+		h = ft_tiles_hash(t, t->tile[n].grid, g[0], g[1]);
+		t->tile[n].chain = t->bucket[h];
+		t->bucket[h] = n;
+		ft_tiles_touch(t, n, 0);
+		ft_tiles_copy(f, ft_tiles_data(t, n), p, 1);
+		ft_store_save(f, t->grid[t->cur].key, g, ft_tiles_data(t, n));
+	}
+	ft_store_end(&t->store);
+}
+
+void	ft_tiles_free(t_fractol *f)
+{
+	free(f->tiles.tile);
+	free(f->tiles.bucket);
+	free(f->tiles.data);
+	free(f->tiles.hit);
+	ft_store_close(&f->tiles.store);
+}
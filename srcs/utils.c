@@ -11,6 +11,7 @@
 /* ************************************************************************** */
 
 #include "../includes/fractol.h"
+#include <sys/stat.h>
 
 /*
  * Converte una stringa in un double (ASCII a float).
@@ -81,3 +82,33 @@ double	ft_atof(const char *str)
 	result += parse_decimal(str, &i);
 	return (sign * result);
 }
+
+/* Current CLOCK_MONOTONIC time in microseconds, the clock used by the
+ deadline that mlx_frame_hook hands to ft_render_frame. */
+long	ft_time_us(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000000L + ts.tv_nsec / 1000);
+}
+
+/* $XDG_CACHE_HOME/fractol or ~/.cache/fractol, created if missing: the
+ JIT libraries and the tile store live there. */
+int	ft_cache_dir(char *dir, size_t size)
+{
+	const char	*base;
+
+	base = getenv("XDG_CACHE_HOME");
+	if (base && *base)
+		snprintf(dir, size, "%s", base);
+	else if (getenv("HOME"))
+		snprintf(dir, size, "%s/.cache", getenv("HOME"));
+	else
+		return (1);
+	mkdir(dir, 0755);
+	ft_strlcat(dir, "/fractol", size);
+	if (mkdir(dir, 0755) != 0 && access(dir, W_OK) != 0)
+		return (1);
+	return (0);
+}
@@ -0,0 +1,247 @@
+#include "../includes/engine.h"
+
+/*
+ * VM DELLE FORMULE - Esegue il bytecode di formula.c su un blocco di
+ * VM_VECS vettori (VM_VECS * VD_LANES pixel) alla volta: ogni istruzione
+ * viene decodificata una volta sola e applicata a tutto il blocco, cosi'
+ * il costo della decodifica si divide su tutti i pixel del blocco e le
+ * operazioni aritmetiche restano vettoriali (csq_d e cmul_d del motore
+ * nativo). Le funzioni trascendenti (sin, cos, exp, log) non hanno una
+ * versione vettoriale in C e vengono calcolate corsia per corsia.
+ *
+ * Un registro e' un numero complesso per ogni pixel del blocco:
+ * v[r][k][0] e v[r][k][1] sono le parti reale e immaginaria del vettore k.
+ */
+
+typedef t_vd	t_vreg[FORMULA_REGS][VM_VECS][2];
+
+/* w = w^n by repeated squaring. */
+static void	vm_pow(t_vd *w, int n)
+{
+	t_vd	base[2];
+	int		first;
+
+	base[0] = w[0];
+	base[1] = w[1];
+	first = 1;
+	while (n)
+	{
+		if ((n & 1) && !first)
+			cmul_d(w, base);
+		if (n & 1)
+			first = 0;
+		n >>= 1;
+		if (n)
+			csq_d(base);
+		if (n && first)
+		{
+			w[0] = base[0];
+			w[1] = base[1];
+		}
+	}
+}
+
+/* Operations, one call per instruction for the whole block. */
+typedef void	(*t_vm_op)(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2]);
+
+static void	vm_mov(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2])
+{
+	int	k;
+
+	(void)in;
+	k = -1;
+	while (++k < VM_VECS)
+	{
+		w[k][0] = z[k][0];
+		w[k][1] = z[k][1];
+	}
+}
+
+static void	vm_const(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2])
+{
+	int	k;
+
+	(void)z;
+	k = -1;
+	while (++k < VM_VECS)
+	{
+		w[k][0] = (t_vd){0} + in->re;
+		w[k][1] = (t_vd){0} + in->im;
+	}
+}
+
+static void	vm_add(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2])
+{
+	int	k;
+
+	(void)in;
+	k = -1;
+	while (++k < VM_VECS)
+	{
+		w[k][0] += z[k][0];
+		w[k][1] += z[k][1];
+	}
+}
+
+static void	vm_sub(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2])
+{
+	int	k;
+
+	(void)in;
+	k = -1;
+	while (++k < VM_VECS)
+	{
+		w[k][0] -= z[k][0];
+		w[k][1] -= z[k][1];
+	}
+}
+
+static void	vm_mul(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2])
+{
+	int	k;
+
+	k = -1;
+	while (++k < VM_VECS)
+	{
+		if (in->op == OP_MUL)
+			cmul_d(w[k], z[k]);
+		else if (in->op == OP_DIV)
+			cdiv_d(w[k], z[k]);
+		else if (in->op == OP_POW)
+			vm_pow(w[k], in->n);
+		else
+			csq_d(w[k]);
+	}
+}
+
+static void	vm_sign(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2])
+{
+	int	k;
+
+	(void)z;
+	k = -1;
+	while (++k < VM_VECS)
+	{
+		if (in->op == OP_NEG)
+			w[k][0] = -w[k][0];
+		if (in->op == OP_NEG || in->op == OP_CONJ)
+			w[k][1] = -w[k][1];
+		if (in->op != OP_ABS)
+			continue ;
+		w[k][0] = vd_select(w[k][0] < 0, -w[k][0], w[k][0]);
+		w[k][1] = vd_select(w[k][1] < 0, -w[k][1], w[k][1]);
+	}
+}
+
+static void	vm_libm(const t_insn *in, t_vd (*w)[2], t_vd (*z)[2])
+{
+	int	k;
+	int	l;
+
+	(void)z;
+	k = -1;
+	while (++k < VM_VECS)
+	{
+		l = -1;
+		while (++l < VD_LANES)
+			clane_d(in->op, &w[k][0][l], &w[k][1][l]);
+	}
+}
+
+/* Indexed by OP_*. */
+static const t_vm_op	g_vm_ops[] = {
+	vm_mov, vm_const, vm_add, vm_sub, vm_mul, vm_mul, vm_sign, vm_mul,
+	vm_libm, vm_libm, vm_libm, vm_libm, vm_sign, vm_sign, vm_mul
+};
+
+/* Runs the program once: FORMULA_OUT receives f(z, c) for the block. */
+static void	vm_run(const t_program *prog, t_vreg v)
+{
+	const t_insn	*in;
+	int				i;
+
+	i = -1;
+	while (++i < prog->count)
+	{
+		in = &prog->code[i];
+		g_vm_ops[in->op](in, v[in->dst], v[in->src]);
+	}
+}
+
+/*
+ * Iterazione con la VM: c e' il pixel, z parte da c (con z = 0 formule come
+ * c*sin(z) resterebbero ferme a 0). Stessa logica del motore nativo: le
+ * corsie fuggite restano ferme e il blocco termina quando sono fuggite tutte.
+ */
+static void	vm_block(const t_frame *fr, t_vreg v, t_vmd *depth)
+{
+	t_vmd	in[VM_VECS];
+	t_vmd	any;
+	int		k;
+	int		n;
+
+	n = -1;
+	while (++n < fr->iteration)
+	{
+		any = (t_vmd){0};
+		k = -1;
+		while (++k < VM_VECS)
+		{
+			in[k] = (v[0][k][0] * v[0][k][0] + v[0][k][1] * v[0][k][1]
+					< fr->bailout);
+			any |= in[k];
+		}
+		if (!vmd_any(any))
+			return ;
+		vm_run(fr->program, v);
+		k = -1;
+		while (++k < VM_VECS)
+		{
+			v[0][k][0] = vd_select(in[k], v[FORMULA_OUT][k][0], v[0][k][0]);
+			v[0][k][1] = vd_select(in[k], v[FORMULA_OUT][k][1], v[0][k][1]);
+			depth[k] -= in[k];
+		}
+	}
+}
+
+/* Escape value of one lane of the block. */
+static float	vm_escape(const t_frame *fr, t_vreg v, t_vmd *depth, int lane)
+{
+	double	re;
+	double	im;
+
+	re = v[0][lane / VD_LANES][0][lane % VD_LANES];
+	im = v[0][lane / VD_LANES][1][lane % VD_LANES];
+	return (escape_value(fr, depth[lane / VD_LANES][lane % VD_LANES],
+			re * re + im * im));
+}
+
+/* Row kernel of the formula type (double precision only). */
+void	formula_d(const t_frame *fr, const t_row *row)
+{
+	t_vreg	v;
+	t_vmd	depth[VM_VECS];
+	int		i;
+	int		k;
+
+	i = 0;
+	while (i < row->count)
+	{
+		k = -1;
+		while (++k < VM_VECS * VD_LANES)
+			v[1][k / VD_LANES][0][k % VD_LANES] = row->re + (i + k) * row->step;
+		k = -1;
+		while (++k < VM_VECS)
+		{
+			v[1][k][1] = (t_vd){0} + row->im;
+			v[0][k][0] = v[1][k][0];
+			v[0][k][1] = v[1][k][1];
+			depth[k] = (t_vmd){0};
+		}
+		vm_block(fr, v, depth);
+		k = -1;
+		while (++k < VM_VECS * VD_LANES && i + k < row->count)
+			row->out[i + k] = vm_escape(fr, v, depth, k);
+		i += VM_VECS * VD_LANES;
+	}
+}
@@ -0,0 +1,79 @@
+#include "../includes/fractol.h"
+
+/*
+ * (Ri)alloca l'immagine XShm in cui viene disegnato il frattale, con le
+ * dimensioni correnti della finestra. La vecchia immagine viene distrutta:
+ * ogni buffer per-pixel deve essere riallocato qui, insieme all'immagine.
+ *
+ * @return 0 in caso di successo, 1 in caso di errore
+ */
+int	ft_image_alloc(t_fractol *f, int width, int height)
+{
+	if (f->mlx.img)
+		mlx_destroy_image(f->mlx.mlx, f->mlx.img);
+	f->mlx.img = mlx_new_image(f->mlx.mlx, width, height);
+	if (!f->mlx.img)
+	{
+		ft_putstr_fd("Error: Failed to create image\n", 2);
+		return (1);
+	}
+	f->mlx.addr = mlx_get_data_addr(f->mlx.img, &f->mlx.bits_per_pixel,
+			&f->mlx.line_length, &f->mlx.endian);
+	if (!f->mlx.addr)
+	{
+		ft_putstr_fd("Error: Failed to get image data address\n", 2);
+		return (1);
+	}
+	free(f->render.values);
+	free(f->render.dist);
+	free(f->render.glitch);
+	f->render.values = malloc(sizeof(float) * width * height);
+	f->render.dist = malloc(sizeof(float) * width * height);
+	f->render.glitch = malloc(width * height);
+	if (!f->render.values || !f->render.dist || !f->render.glitch)
+	{
+		ft_putstr_fd("Error: Failed to allocate the frame buffers\n", 2);
+		return (1);
+	}
+	f->mlx.width = width;
+	f->mlx.height = height;
+	return (0);
+}
+
+/* ConfigureNotify hook: reallocates the buffers when the window size changes
+ (moves are ignored) and derives the offsets again from the center, so the
+ view stays centred. */
+int	resize_window(int width, int height, t_fractol *f)
+{
+	if (width < 1 || height < 1
+		|| (width == f->mlx.width && height == f->mlx.height))
+		return (0);
+	if (ft_image_alloc(f, width, height) != 0)
+		clean_exit(f, 1);
+	ft_view_move(f, 0, 0);
+	ft_draw(f);
+	return (0);
+}
+
+/* Switch fullscreen on/off. The image is resized to the screen size right
+ away; the ConfigureNotify sent by the window manager is then a no-op. */
+void	toggle_fullscreen(t_fractol *f)
+{
+	int	width;
+	int	height;
+
+	f->mlx.fullscreen = !f->mlx.fullscreen;
+	if (f->mlx.fullscreen)
+	{
+		f->mlx.saved_width = f->mlx.width;
+		f->mlx.saved_height = f->mlx.height;
+		mlx_get_screen_size(f->mlx.mlx, &width, &height);
+	}
+	else
+	{
+		width = f->mlx.saved_width;
+		height = f->mlx.saved_height;
+	}
+	mlx_window_fullscreen(f->mlx.mlx, f->mlx.win, f->mlx.fullscreen);
+	resize_window(width, height, f);
+}